@@ -0,0 +1,172 @@
+/*
+ * This file is part of the Marmalade SDK Code Samples.
+ *
+ * Copyright (C) 2001-2011 Ideaworks3D Ltd.
+ * All Rights Reserved.
+ *
+ * This source code is intended only as a supplement to Ideaworks Labs
+ * Development Tools and/or on-line documentation.
+ *
+ * THIS CODE AND INFORMATION ARE PROVIDED "AS IS" WITHOUT WARRANTY OF ANY
+ * KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+ * PARTICULAR PURPOSE.
+ */
+#include "Adpcm.h"
+
+static const int16 s_StepTable[89] =
+{
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+    50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143, 157, 173, 190, 209, 230,
+    253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658, 724, 796, 876, 963,
+    1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749, 3024, 3327,
+    3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442,
+    11487, 12635, 13899, 15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794,
+    32767
+};
+
+static const int8 s_IndexTable[16] =
+{
+    -1, -1, -1, -1, 2, 4, 6, 8,
+    -1, -1, -1, -1, 2, 4, 6, 8
+};
+
+typedef struct AdpcmState
+{
+    int32 m_Predictor;
+    int32 m_Index;
+} AdpcmState;
+
+// Every sample depends on the one before it, so a single channel cannot be
+// split across SIMD lanes. The nibble is expanded without branches instead,
+// which keeps the loop free of mispredicts on noisy material.
+static inline int16 DecodeNibble(AdpcmState* s, int nibble)
+{
+    int32 step = s_StepTable[s->m_Index];
+    int32 diff = step >> 3;
+    diff += step & -((nibble >> 2) & 1);
+    diff += (step >> 1) & -((nibble >> 1) & 1);
+    diff += (step >> 2) & -(nibble & 1);
+
+    int32 sign = -((nibble >> 3) & 1);
+    int32 pred = s->m_Predictor + ((diff ^ sign) - sign);
+    if (pred > 32767)
+        pred = 32767;
+    else if (pred < -32768)
+        pred = -32768;
+    s->m_Predictor = pred;
+
+    int32 index = s->m_Index + s_IndexTable[nibble];
+    s->m_Index = index < 0 ? 0 : index > 88 ? 88 : index;
+    return (int16)pred;
+}
+
+static inline void ReadHeader(const uint8* p, AdpcmState* s)
+{
+    s->m_Predictor = (int16)(p[0] | (p[1] << 8));
+    s->m_Index = p[2] > 88 ? 88 : p[2];
+}
+
+int AdpcmBlockFrames(int bytes, int channels)
+{
+    int header = 4 * channels;
+    if (bytes < header)
+        return 0;
+
+    // Sample data comes in 4 byte groups per channel after the headers
+    int groups = (bytes - header) / (4 * channels);
+    return groups * 8 + 1;
+}
+
+int AdpcmDecodeBlock(const uint8* pBlock, int bytes, int channels, int16* pDst)
+{
+    int frames = AdpcmBlockFrames(bytes, channels);
+    if (!frames)
+        return 0;
+
+    AdpcmState s[ADPCM_MAX_CHANNELS];
+    const uint8* p = pBlock;
+
+    if (channels == 1)
+    {
+        ReadHeader(p, &s[0]);
+        p += 4;
+        *pDst++ = (int16)s[0].m_Predictor;
+
+        for (int i = 1; i < frames; i += 2, p++)
+        {
+            pDst[0] = DecodeNibble(&s[0], *p & 0xf);
+            pDst[1] = DecodeNibble(&s[0], *p >> 4);
+            pDst += 2;
+        }
+        return frames;
+    }
+
+    // Stereo: decode each 8 frame group of both channels and average
+    ReadHeader(p, &s[0]);
+    ReadHeader(p + 4, &s[1]);
+    p += 8;
+    *pDst++ = (int16)((s[0].m_Predictor + s[1].m_Predictor) >> 1);
+
+    for (int i = 1; i < frames; i += 8, p += 8)
+    {
+        int16 left[8];
+        for (int j = 0; j < 4; j++)
+        {
+            left[j*2] = DecodeNibble(&s[0], p[j] & 0xf);
+            left[j*2 + 1] = DecodeNibble(&s[0], p[j] >> 4);
+        }
+        for (int j = 0; j < 4; j++)
+        {
+            int16 r0 = DecodeNibble(&s[1], p[4 + j] & 0xf);
+            int16 r1 = DecodeNibble(&s[1], p[4 + j] >> 4);
+            pDst[j*2] = (int16)((left[j*2] + r0) >> 1);
+            pDst[j*2 + 1] = (int16)((left[j*2 + 1] + r1) >> 1);
+        }
+        pDst += 8;
+    }
+    return frames;
+}
+
+//-----------------------------------------------------------------------------
+// Playback
+//-----------------------------------------------------------------------------
+static void DecodeNext(AdpcmCursor* c)
+{
+    const SoundSample* pSample = c->m_pSample;
+    int offset = c->m_NextBlock * pSample->m_BlockAlign;
+    int bytes = pSample->m_EncodedLen - offset;
+    if (bytes > pSample->m_BlockAlign)
+        bytes = pSample->m_BlockAlign;
+
+    c->m_DecodedLen = AdpcmDecodeBlock(pSample->m_pEncoded + offset, bytes, pSample->m_NumChannels, c->m_Decoded);
+    c->m_DecodedPos = 0;
+    c->m_NextBlock++;
+}
+
+void AdpcmCursorSeek(AdpcmCursor* c, const SoundSample* pSample, int32 frame)
+{
+    c->m_pSample = pSample;
+    c->m_NumBlocks = (pSample->m_EncodedLen + pSample->m_BlockAlign - 1) / pSample->m_BlockAlign;
+    c->m_NextBlock = frame / pSample->m_FramesPerBlock;
+    DecodeNext(c);
+    c->m_DecodedPos = frame % pSample->m_FramesPerBlock;
+}
+
+int AdpcmCursorRead(AdpcmCursor* c, int frames, const int16** ppSrc)
+{
+    if (c->m_DecodedPos >= c->m_DecodedLen)
+    {
+        if (c->m_NextBlock >= c->m_NumBlocks)
+            return 0;
+        DecodeNext(c);
+    }
+
+    int n = c->m_DecodedLen - c->m_DecodedPos;
+    if (n > frames)
+        n = frames;
+
+    *ppSrc = c->m_Decoded + c->m_DecodedPos;
+    c->m_DecodedPos += n;
+    return n;
+}
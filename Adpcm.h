@@ -0,0 +1,68 @@
+/*
+ * This file is part of the Marmalade SDK Code Samples.
+ *
+ * Copyright (C) 2001-2011 Ideaworks3D Ltd.
+ * All Rights Reserved.
+ *
+ * This source code is intended only as a supplement to Ideaworks Labs
+ * Development Tools and/or on-line documentation.
+ *
+ * THIS CODE AND INFORMATION ARE PROVIDED "AS IS" WITHOUT WARRANTY OF ANY
+ * KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+ * PARTICULAR PURPOSE.
+ */
+// IMA-ADPCM decoding of compressed samples
+//-----------------------------------------------------------------------------
+
+#ifndef ADPCM_H
+#define ADPCM_H
+
+#include "s3eTypes.h"
+#include "SoundSample.h"
+
+#define ADPCM_MAX_CHANNELS      2
+#define ADPCM_MAX_BLOCK_FRAMES  4096
+
+/**
+ * Frames held by an IMA-ADPCM block of @a bytes bytes. Works for the short
+ * final block of a file as well as full blocks. Returns 0 if @a bytes is
+ * too small to hold the block header.
+ */
+int AdpcmBlockFrames(int bytes, int channels);
+
+/**
+ * Decode one IMA-ADPCM block of @a bytes bytes to 16 bit mono, averaging
+ * stereo blocks. @a pDst must hold AdpcmBlockFrames(bytes, channels) frames.
+ * @return number of frames decoded.
+ */
+int AdpcmDecodeBlock(const uint8* pBlock, int bytes, int channels, int16* pDst);
+
+/**
+ * Decode position in a compressed sample. Only one block is decoded at a
+ * time, into m_Decoded, which the owner allocates with room for
+ * ADPCM_MAX_BLOCK_FRAMES frames.
+ */
+typedef struct AdpcmCursor
+{
+    const SoundSample* m_pSample;
+    int     m_NumBlocks;
+    int     m_NextBlock;        // block to decode once m_Decoded runs out
+    int     m_DecodedPos;       // next frame to read from m_Decoded
+    int     m_DecodedLen;
+    int16*  m_Decoded;
+} AdpcmCursor;
+
+/**
+ * Position @a c at @a frame of the compressed sample @a pSample.
+ */
+void AdpcmCursorSeek(AdpcmCursor* c, const SoundSample* pSample, int32 frame);
+
+/**
+ * Point @a ppSrc at up to @a frames decoded frames from the cursor and
+ * advance past them. The frames stay valid until the next call.
+ * @return frames available, 0 at the end of the sample.
+ */
+int AdpcmCursorRead(AdpcmCursor* c, int frames, const int16** ppSrc);
+
+#endif /* !ADPCM_H */
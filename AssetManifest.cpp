@@ -0,0 +1,220 @@
+/*
+ * This file is part of the Marmalade SDK Code Samples.
+ *
+ * Copyright (C) 2001-2011 Ideaworks3D Ltd.
+ * All Rights Reserved.
+ *
+ * This source code is intended only as a supplement to Ideaworks Labs
+ * Development Tools and/or on-line documentation.
+ *
+ * THIS CODE AND INFORMATION ARE PROVIDED "AS IS" WITHOUT WARRANTY OF ANY
+ * KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+ * PARTICULAR PURPOSE.
+ */
+#include "AssetManifest.h"
+#include "s3eDebug.h"
+#include <stdio.h>
+#include <string.h>
+#include <malloc.h>
+#include <memory.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <time.h>
+
+// Upper bound on entries accepted from a manifest file
+#define ASSETMANIFEST_MAX_ENTRIES 1024
+
+static bool StatFile(const char* pPath, uint32* pSize, uint32* pMTime)
+{
+    struct stat st;
+    if (stat(pPath, &st))
+        return false;
+
+    if (pSize)
+        *pSize = (uint32)st.st_size;
+    *pMTime = (uint32)st.st_mtime;
+    return true;
+}
+
+static void MakePath(char* pDst, int len, const char* pDir, const char* pName)
+{
+    if (!strcmp(pDir, "."))
+        snprintf(pDst, len, "%s", pName);
+    else
+        snprintf(pDst, len, "%s/%s", pDir, pName);
+}
+
+static AssetManifestEntry* ReadManifest(const char* pPath, uint32* pDirMTime, int* pCount)
+{
+    FILE* f = fopen(pPath, "rb");
+    if (!f)
+        return NULL;
+
+    AssetManifestHeader h;
+    AssetManifestEntry* pEntries = NULL;
+    if (fread(&h, sizeof(h), 1, f) == 1 && !memcmp(h.m_Magic, ASSETMANIFEST_MAGIC, 4) &&
+        h.m_Version == ASSETMANIFEST_VERSION && h.m_NumEntries <= ASSETMANIFEST_MAX_ENTRIES)
+    {
+        pEntries = (AssetManifestEntry*)malloc((h.m_NumEntries ? h.m_NumEntries : 1) * sizeof(AssetManifestEntry));
+        if (pEntries && fread(pEntries, sizeof(AssetManifestEntry), h.m_NumEntries, f) != h.m_NumEntries)
+        {
+            free(pEntries);
+            pEntries = NULL;
+        }
+    }
+    fclose(f);
+
+    if (!pEntries)
+    {
+        s3eDebugTracePrintf("manifest: ignoring %s", pPath);
+        return NULL;
+    }
+
+    for (uint32 i = 0; i < h.m_NumEntries; i++)
+        pEntries[i].m_Name[ASSETMANIFEST_MAX_NAME - 1] = '\0';
+
+    *pDirMTime = h.m_DirMTime;
+    *pCount = h.m_NumEntries;
+    return pEntries;
+}
+
+static void WriteManifest(const char* pPath, const char* pDir, uint32 dirMTime, const AssetManifestEntry* pEntries, int count)
+{
+    AssetManifestHeader h;
+    memcpy(h.m_Magic, ASSETMANIFEST_MAGIC, 4);
+    h.m_Version = ASSETMANIFEST_VERSION;
+    h.m_DirMTime = dirMTime;
+    h.m_NumEntries = count;
+
+    FILE* f = fopen(pPath, "wb");
+    if (!f)
+    {
+        s3eDebugTracePrintf("manifest: can't write %s", pPath);
+        return;
+    }
+    fwrite(&h, sizeof(h), 1, f);
+    fwrite(pEntries, sizeof(AssetManifestEntry), count, f);
+    fclose(f);
+
+    // Creating the manifest inside the directory it describes changes the
+    // directory's time; record the new one or the next run would rescan.
+    // Times are in whole seconds, so a directory changed this second could
+    // change again unnoticed; leave those to be read again next time.
+    StatFile(pDir, NULL, &h.m_DirMTime);
+    if (h.m_DirMTime >= (uint32)time(NULL))
+        h.m_DirMTime = 0;
+    if (h.m_DirMTime != dirMTime && (f = fopen(pPath, "r+b")))
+    {
+        fwrite(&h, sizeof(h), 1, f);
+        fclose(f);
+    }
+}
+
+// Re-parse @a pEntry if its file is new (@a known false) or differs in
+// size or time from when it was last parsed, counting it in @a pParsed.
+// Returns false if the file no longer exists.
+static bool Refresh(const char* pDir, AssetManifestEntry* pEntry, bool known, int* pParsed)
+{
+    char path[512];
+    MakePath(path, sizeof(path), pDir, pEntry->m_Name);
+
+    uint32 size = 0;
+    uint32 mtime = 0;
+    bool exists = StatFile(path, &size, &mtime);
+    if (known && exists && size == pEntry->m_Size && mtime == pEntry->m_MTime)
+        return true;
+
+    // A file written this second may be written again within it, so its
+    // time is not trusted until the next run
+    pEntry->m_Size = size;
+    pEntry->m_MTime = mtime < (uint32)time(NULL) ? mtime : 0;
+    pEntry->m_Valid = exists && WavGetInfo(path, &pEntry->m_Info);
+    (*pParsed)++;
+    return exists;
+}
+
+static const AssetManifestEntry* Find(const AssetManifestEntry* pEntries, int count, const char* pName)
+{
+    for (int i = 0; i < count; i++)
+    {
+        if (!strcmp(pEntries[i].m_Name, pName))
+            return &pEntries[i];
+    }
+    return NULL;
+}
+
+int AssetManifestScan(const char* pDir, const char* pManifestPath, AssetManifestEntry* pEntries, int maxEntries)
+{
+    bool useManifest = pManifestPath && pManifestPath[0];
+
+    uint32 dirMTime = 0;
+    StatFile(pDir, NULL, &dirMTime);
+
+    uint32 oldDirMTime = 0;
+    int oldCount = 0;
+    AssetManifestEntry* pOld = useManifest ? ReadManifest(pManifestPath, &oldDirMTime, &oldCount) : NULL;
+
+    int count = 0;
+    int parsed = 0;
+    bool listed = pOld && oldDirMTime == dirMTime;
+    if (listed)
+    {
+        // No files have been added, removed or renamed, so the manifest's
+        // list stands; only check each file's size and time. Directory
+        // times are coarse, so a file that has gone means it was wrong.
+        for (; count < oldCount && count < maxEntries; count++)
+        {
+            pEntries[count] = pOld[count];
+            if (!Refresh(pDir, &pEntries[count], true, &parsed))
+            {
+                listed = false;
+                count = 0;
+                parsed = 0;
+                break;
+            }
+        }
+    }
+
+    if (!listed)
+    {
+        DIR* d = opendir(pDir);
+        struct dirent* ent;
+        while (d && count < maxEntries && (ent = readdir(d)))
+        {
+            int len = strlen(ent->d_name);
+            if (len < 4 || stricmp(ent->d_name+len-4, ".wav"))
+                continue;
+
+            if (len >= ASSETMANIFEST_MAX_NAME)
+            {
+                s3eDebugTracePrintf("manifest: skipping %s, name too long", ent->d_name);
+                continue;
+            }
+
+            AssetManifestEntry* e = &pEntries[count++];
+            const AssetManifestEntry* pPrev = Find(pOld, oldCount, ent->d_name);
+            if (pPrev)
+            {
+                *e = *pPrev;
+            }
+            else
+            {
+                memset(e, 0, sizeof(AssetManifestEntry));
+                strcpy(e->m_Name, ent->d_name);
+            }
+
+            Refresh(pDir, e, pPrev != NULL, &parsed);
+        }
+        if (d)
+            closedir(d);
+    }
+
+    if (useManifest && (!listed || parsed))
+        WriteManifest(pManifestPath, pDir, dirMTime, pEntries, count);
+
+    s3eDebugTracePrintf("manifest: %d files, %d parsed%s", count, parsed, listed ? ", directory not read" : "");
+
+    free(pOld);
+    return count;
+}
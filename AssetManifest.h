@@ -0,0 +1,69 @@
+/*
+ * This file is part of the Marmalade SDK Code Samples.
+ *
+ * Copyright (C) 2001-2011 Ideaworks3D Ltd.
+ * All Rights Reserved.
+ *
+ * This source code is intended only as a supplement to Ideaworks Labs
+ * Development Tools and/or on-line documentation.
+ *
+ * THIS CODE AND INFORMATION ARE PROVIDED "AS IS" WITHOUT WARRANTY OF ANY
+ * KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+ * PARTICULAR PURPOSE.
+ */
+// Cached list of the .wav files in a directory and their parsed headers
+//-----------------------------------------------------------------------------
+
+#ifndef ASSET_MANIFEST_H
+#define ASSET_MANIFEST_H
+
+#include "s3eTypes.h"
+#include "WavFile.h"
+
+/*
+ * Manifest file layout (native byte order; the file is a cache and is
+ * rebuilt if anything about it looks wrong):
+ *
+ *   AssetManifestHeader
+ *   AssetManifestEntry[m_NumEntries]   in directory order
+ *
+ * The directory's modification time is recorded so that, while no files
+ * have been added, removed or renamed, startup can skip reading the
+ * directory altogether. Each entry records the size and modification time
+ * of its file so changed files are noticed without opening them.
+ */
+#define ASSETMANIFEST_MAGIC     "SMAN"
+#define ASSETMANIFEST_VERSION   2
+#define ASSETMANIFEST_MAX_NAME  128
+
+typedef struct AssetManifestHeader
+{
+    char    m_Magic[4];
+    uint32  m_Version;
+    uint32  m_DirMTime;
+    uint32  m_NumEntries;
+} AssetManifestHeader;
+
+typedef struct AssetManifestEntry
+{
+    char    m_Name[ASSETMANIFEST_MAX_NAME];   // file name, including .wav
+    uint32  m_Size;
+    uint32  m_MTime;
+    bool    m_Valid;                        // false if the header did not parse
+    WavInfo m_Info;
+} AssetManifestEntry;
+
+/**
+ * List up to @a maxEntries .wav files in @a pDir into @a pEntries, using and
+ * refreshing the manifest at @a pManifestPath. Only files that are new or
+ * have changed since the manifest was written are parsed; the rest are
+ * taken from the manifest without being opened. Files whose headers do not
+ * parse are still listed, with m_Valid false.
+ *
+ * With a NULL or empty @a pManifestPath every file is parsed.
+ * @return the number of entries filled in.
+ */
+int AssetManifestScan(const char* pDir, const char* pManifestPath, AssetManifestEntry* pEntries, int maxEntries);
+
+#endif /* !ASSET_MANIFEST_H */
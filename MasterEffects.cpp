@@ -0,0 +1,531 @@
+/*
+ * This file is part of the Marmalade SDK Code Samples.
+ *
+ * Copyright (C) 2001-2011 Ideaworks3D Ltd.
+ * All Rights Reserved.
+ *
+ * This source code is intended only as a supplement to Ideaworks Labs
+ * Development Tools and/or on-line documentation.
+ *
+ * THIS CODE AND INFORMATION ARE PROVIDED "AS IS" WITHOUT WARRANTY OF ANY
+ * KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+ * PARTICULAR PURPOSE.
+ */
+#include "MasterEffects.h"
+#include "s3eDebug.h"
+#include <malloc.h>
+#include <memory.h>
+#include <math.h>
+
+// Frames between recalculations of the compressor gain, which is ramped
+// linearly in between
+#define COMPRESSOR_CHUNK    16
+
+#define REVERB_COMBS        4
+
+// Sliding minimum of the limiter gain; a power of two above the longest
+// hold window
+#define LIMITER_HOLD_RING   1024
+#define LIMITER_HOLD_MASK   (LIMITER_HOLD_RING - 1)
+
+#if LIMITER_HOLD_RING <= MASTEREFFECTS_MAX_LOOKAHEAD
+#error the hold ring must cover the look-ahead and one more frame
+#endif
+
+// Gains are .15, so unity is one past the largest int16
+#define UNITY_Q15           0x8000
+
+/*
+ * Settings are written by the main thread and read by the callback; each is
+ * a single word, so a block may see a mix of old and new settings but never
+ * a torn value. Anything that changes the size of a stage's state is only
+ * picked up when the callback restarts the stage.
+ */
+typedef struct FxStage
+{
+    volatile bool m_Bypass;
+    volatile bool m_Restart;    // set by the main thread, cleared by the callback
+    bool    m_Running;          // callback only
+} FxStage;
+
+typedef struct FxCompressor
+{
+    // Settings
+    int32   m_Threshold;        // sample level
+    float   m_Slope;            // output dB per input dB over the threshold, less 1
+    int32   m_Makeup;           // .16
+    int32   m_Attack;           // envelope coefficients, .15
+    int32   m_Release;
+
+    // Callback state
+    int32   m_Env;              // peak envelope, sample level
+    int32   m_Gain;             // .16
+    int32   m_GainStep;
+    int     m_ChunkLeft;
+} FxCompressor;
+
+typedef struct FxReverb
+{
+    // Settings
+    int     m_Len[REVERB_COMBS];
+    int32   m_Feedback;         // .15
+    int32   m_Damping;          // .15
+    int32   m_Wet;              // .15
+
+    // Callback state
+    int32*  m_pBuf[REVERB_COMBS];
+    int     m_ActiveLen[REVERB_COMBS];
+    int     m_Pos[REVERB_COMBS];
+    int32   m_Filter[REVERB_COMBS];
+} FxReverb;
+
+typedef struct FxLimiter
+{
+    // Settings
+    int32   m_Ceiling;          // sample level
+    int     m_Lookahead;        // frames
+    int32   m_ReleaseCoef;      // .15
+
+    // Callback state
+    int     m_Len;              // look-ahead in use
+    uint32  m_InvLen;           // .24, rounded up
+    uint32  m_Frame;
+    int32   m_Release;          // gain recovering towards unity, .15
+    uint32  m_HoldFront;
+    uint32  m_HoldBack;
+    uint32  m_HoldFrame[LIMITER_HOLD_RING];
+    int32   m_HoldGain[LIMITER_HOLD_RING];
+    int32   m_Box[MASTEREFFECTS_MAX_LOOKAHEAD];
+    int     m_BoxPos;
+    int32   m_BoxSum;
+    int32   m_Delay[MASTEREFFECTS_MAX_LOOKAHEAD * 2];
+} FxLimiter;
+
+// Comb lengths as a fraction of the longest, in 1/1000ths, with no common
+// factors so their echoes don't line up
+static const int g_FxCombScale[REVERB_COMBS] = { 1000, 922, 839, 735 };
+
+static FxStage g_FxStages[MASTEREFFECT_STAGES] =
+{
+    { true, false, false },
+    { true, false, false },
+    { true, false, false },
+};
+static uint32 g_FxRate = 0;
+static FxCompressor g_FxCompressor;
+static FxReverb g_FxReverb;
+static FxLimiter g_FxLimiter;
+static int32* g_FxReverbMem = NULL;
+static MasterCompressorParams g_FxCompressorParams;
+static MasterReverbParams g_FxReverbParams;
+static MasterLimiterParams g_FxLimiterParams;
+
+static inline int Clamp(int v, int lo, int hi)
+{
+    return v < lo ? lo : v > hi ? hi : v;
+}
+
+static inline int32 Abs(int32 v)
+{
+    return v < 0 ? -v : v;
+}
+
+static int MsToFrames(int ms)
+{
+    return (int)((int64)ms * g_FxRate / 1000);
+}
+
+// Linear gain of @a db, scaled by @a one
+static int32 DbToGain(int db, int32 one)
+{
+    return (int32)(pow(10.0, db / 20.0) * one + 0.5);
+}
+
+// One pole smoothing coefficient that settles over @a ms, .15
+static int32 TimeCoef(int ms)
+{
+    int frames = MsToFrames(ms);
+    if (frames < 1)
+        return UNITY_Q15;
+    return (int32)((1.0 - exp(-1.0 / frames)) * UNITY_Q15 + 0.5);
+}
+
+//-----------------------------------------------------------------------------
+// Compressor: feed forward, peak detecting, linked across channels
+//-----------------------------------------------------------------------------
+static void CompressorRestart()
+{
+    FxCompressor* c = &g_FxCompressor;
+    c->m_Env = 0;
+    c->m_Gain = c->m_Makeup;
+    c->m_GainStep = 0;
+    c->m_ChunkLeft = 0;
+}
+
+static int32 CompressorGain(const FxCompressor* c)
+{
+    if (c->m_Env <= c->m_Threshold)
+        return c->m_Makeup;
+    return (int32)(c->m_Makeup * powf((float)c->m_Env / c->m_Threshold, c->m_Slope));
+}
+
+static void CompressorProcess(int32* pAccum, int frames, int channels)
+{
+    FxCompressor* c = &g_FxCompressor;
+    int32 env = c->m_Env;
+    int32 gain = c->m_Gain;
+
+    for (int i = 0; i < frames; i++, pAccum += channels)
+    {
+        if (!c->m_ChunkLeft)
+        {
+            c->m_Env = env;
+            c->m_GainStep = (CompressorGain(c) - gain) / COMPRESSOR_CHUNK;
+            c->m_ChunkLeft = COMPRESSOR_CHUNK;
+        }
+        c->m_ChunkLeft--;
+
+        int32 level = Abs(pAccum[0]);
+        if (channels == 2 && Abs(pAccum[1]) > level)
+            level = Abs(pAccum[1]);
+        int32 coef = level > env ? c->m_Attack : c->m_Release;
+        env += (int32)(((int64)(level - env) * coef) >> 15);
+
+        pAccum[0] = (int32)(((int64)pAccum[0] * gain) >> 16);
+        if (channels == 2)
+            pAccum[1] = (int32)(((int64)pAccum[1] * gain) >> 16);
+        gain += c->m_GainStep;
+    }
+
+    c->m_Env = env;
+    c->m_Gain = gain;
+}
+
+//-----------------------------------------------------------------------------
+// Reverb: parallel damped feedback combs on the mono sum
+//-----------------------------------------------------------------------------
+static void ReverbRestart()
+{
+    FxReverb* r = &g_FxReverb;
+    for (int i = 0; i < REVERB_COMBS; i++)
+    {
+        r->m_ActiveLen[i] = r->m_Len[i];
+        r->m_Pos[i] = 0;
+        r->m_Filter[i] = 0;
+        memset(r->m_pBuf[i], 0, r->m_ActiveLen[i] * sizeof(int32));
+    }
+}
+
+static void ReverbProcess(int32* pAccum, int frames, int channels)
+{
+    FxReverb* r = &g_FxReverb;
+    int32 feedback = r->m_Feedback;
+    int32 damping = r->m_Damping;
+    int32 wet = r->m_Wet;
+
+    for (int i = 0; i < frames; i++, pAccum += channels)
+    {
+        // Quartered, as the four combs are summed
+        int32 in = (channels == 2 ? (pAccum[0] >> 1) + (pAccum[1] >> 1) : pAccum[0]) >> 2;
+
+        int32 out[REVERB_COMBS];
+        for (int c = 0; c < REVERB_COMBS; c++)
+        {
+            int32* p = r->m_pBuf[c] + r->m_Pos[c];
+            int32 y = *p;
+            r->m_Filter[c] = y + (int32)(((int64)(r->m_Filter[c] - y) * damping) >> 15);
+            *p = in + (int32)(((int64)r->m_Filter[c] * feedback) >> 15);
+            if (++r->m_Pos[c] >= r->m_ActiveLen[c])
+                r->m_Pos[c] = 0;
+            out[c] = y;
+        }
+
+        // Alternate combs to each side for some width
+        if (channels == 2)
+        {
+            pAccum[0] += (int32)(((int64)(out[0] + out[2]) * wet) >> 15);
+            pAccum[1] += (int32)(((int64)(out[1] + out[3]) * wet) >> 15);
+        }
+        else
+        {
+            pAccum[0] += (int32)(((int64)((out[0] + out[1] + out[2] + out[3]) >> 1) * wet) >> 15);
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+// Limiter: the output is delayed by the look-ahead, and the gain each frame
+// needs is held for the look-ahead and averaged over it, so the gain has
+// come all the way down by the time the frame that needed it comes out.
+//-----------------------------------------------------------------------------
+static void LimiterRestart()
+{
+    FxLimiter* l = &g_FxLimiter;
+    l->m_Len = l->m_Lookahead;
+    l->m_InvLen = (uint32)(((1 << 24) + l->m_Len - 1) / l->m_Len);
+    l->m_Frame = 0;
+    l->m_Release = UNITY_Q15;
+    l->m_HoldFront = l->m_HoldBack = 0;
+    for (int i = 0; i < l->m_Len; i++)
+        l->m_Box[i] = UNITY_Q15;
+    l->m_BoxPos = 0;
+    l->m_BoxSum = l->m_Len * UNITY_Q15;
+    memset(l->m_Delay, 0, sizeof(l->m_Delay));
+}
+
+static void LimiterProcess(int32* pAccum, int frames, int channels)
+{
+    FxLimiter* l = &g_FxLimiter;
+    int32 ceiling = l->m_Ceiling;
+    int32 releaseCoef = l->m_ReleaseCoef;
+    uint32 window = l->m_Len + 1;
+
+    for (int i = 0; i < frames; i++, pAccum += channels)
+    {
+        int32 peak = Abs(pAccum[0]);
+        if (channels == 2 && Abs(pAccum[1]) > peak)
+            peak = Abs(pAccum[1]);
+
+        // Gain this frame needs, with the release limiting how fast the
+        // gain can recover afterwards
+        int32 gain = l->m_Release + (((UNITY_Q15 - l->m_Release) * releaseCoef) >> 15);
+        if (peak > ceiling)
+        {
+            int32 need = (int32)(((int64)ceiling << 15) / peak);
+            if (need < gain)
+                gain = need;
+        }
+        l->m_Release = gain;
+
+        // Lowest gain of the last window frames
+        while (l->m_HoldBack != l->m_HoldFront && l->m_HoldGain[(l->m_HoldBack - 1) & LIMITER_HOLD_MASK] >= gain)
+            l->m_HoldBack--;
+        l->m_HoldFrame[l->m_HoldBack & LIMITER_HOLD_MASK] = l->m_Frame;
+        l->m_HoldGain[l->m_HoldBack & LIMITER_HOLD_MASK] = gain;
+        l->m_HoldBack++;
+        if (l->m_Frame - l->m_HoldFrame[l->m_HoldFront & LIMITER_HOLD_MASK] >= window)
+            l->m_HoldFront++;
+        int32 hold = l->m_HoldGain[l->m_HoldFront & LIMITER_HOLD_MASK];
+        l->m_Frame++;
+
+        // Averaged over the look-ahead, so the gain moves smoothly
+        l->m_BoxSum += hold - l->m_Box[l->m_BoxPos];
+        l->m_Box[l->m_BoxPos] = hold;
+        int32* pDelay = l->m_Delay + l->m_BoxPos * 2;
+        if (++l->m_BoxPos == l->m_Len)
+            l->m_BoxPos = 0;
+        int32 smooth = (int32)(((int64)l->m_BoxSum * l->m_InvLen) >> 24);
+        if (smooth > UNITY_Q15)
+            smooth = UNITY_Q15;
+
+        // Swap the frame into the delay line for the one a look-ahead ago
+        for (int ch = 0; ch < channels; ch++)
+        {
+            int32 out = pDelay[ch];
+            pDelay[ch] = pAccum[ch];
+            pAccum[ch] = (int32)(((int64)out * smooth) >> 15);
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+// Chain
+//-----------------------------------------------------------------------------
+typedef void (*FxRestartFn)();
+typedef void (*FxProcessFn)(int32* pAccum, int frames, int channels);
+
+static const FxRestartFn g_FxRestart[MASTEREFFECT_STAGES] =
+{
+    CompressorRestart,
+    ReverbRestart,
+    LimiterRestart,
+};
+
+static const FxProcessFn g_FxProcess[MASTEREFFECT_STAGES] =
+{
+    CompressorProcess,
+    ReverbProcess,
+    LimiterProcess,
+};
+
+bool MasterEffectsInit(uint32 sampleRate)
+{
+    MasterEffectsTerminate();
+    if (!sampleRate)
+        return false;
+    g_FxRate = sampleRate;
+
+    int maxLen = MsToFrames(MASTEREFFECTS_MAX_DELAY_MS);
+    g_FxReverbMem = (int32*)malloc(REVERB_COMBS * maxLen * sizeof(int32));
+    if (!g_FxReverbMem)
+        return false;
+    for (int i = 0; i < REVERB_COMBS; i++)
+        g_FxReverb.m_pBuf[i] = g_FxReverbMem + i * maxLen;
+
+    MasterCompressorParams compressor;
+    compressor.m_ThresholdDb = -12;
+    compressor.m_Ratio = 4;
+    compressor.m_AttackMs = 5;
+    compressor.m_ReleaseMs = 100;
+    compressor.m_MakeupDb = 0;
+    MasterEffectsSetCompressor(&compressor);
+
+    MasterReverbParams reverb;
+    reverb.m_DelayMs = 40;
+    reverb.m_Feedback = 70;
+    reverb.m_Damping = 30;
+    reverb.m_Wet = 20;
+    MasterEffectsSetReverb(&reverb);
+
+    MasterLimiterParams limiter;
+    limiter.m_CeilingDb = -1;
+    limiter.m_LookaheadMs = 2;
+    limiter.m_ReleaseMs = 80;
+    MasterEffectsSetLimiter(&limiter);
+    return true;
+}
+
+void MasterEffectsSetBypass(MasterEffectStage stage, bool bypass)
+{
+    // Nothing runs before MasterEffectsInit()
+    if (stage < 0 || stage >= MASTEREFFECT_STAGES || (!bypass && !g_FxReverbMem))
+        return;
+    g_FxStages[stage].m_Bypass = bypass;
+}
+
+bool MasterEffectsIsBypassed(MasterEffectStage stage)
+{
+    return stage < 0 || stage >= MASTEREFFECT_STAGES || g_FxStages[stage].m_Bypass;
+}
+
+void MasterEffectsSetCompressor(const MasterCompressorParams* pParams)
+{
+    // Settings are worked out for the output rate, which MasterEffectsInit()
+    // sets, and it replaces them with defaults anyway
+    if (!g_FxRate)
+        return;
+
+    MasterCompressorParams* p = &g_FxCompressorParams;
+    *p = *pParams;
+    p->m_ThresholdDb = Clamp(p->m_ThresholdDb, -60, 0);
+    p->m_Ratio = Clamp(p->m_Ratio, 1, 100);
+    p->m_AttackMs = Clamp(p->m_AttackMs, 0, 1000);
+    p->m_ReleaseMs = Clamp(p->m_ReleaseMs, 0, 5000);
+    p->m_MakeupDb = Clamp(p->m_MakeupDb, 0, 24);
+
+    FxCompressor* c = &g_FxCompressor;
+    c->m_Threshold = DbToGain(p->m_ThresholdDb, 32767);
+    c->m_Slope = 1.0f / p->m_Ratio - 1.0f;
+    c->m_Makeup = DbToGain(p->m_MakeupDb, 0x10000);
+    c->m_Attack = TimeCoef(p->m_AttackMs);
+    c->m_Release = TimeCoef(p->m_ReleaseMs);
+}
+
+void MasterEffectsSetReverb(const MasterReverbParams* pParams)
+{
+    // As for the compressor
+    if (!g_FxRate)
+        return;
+
+    MasterReverbParams* p = &g_FxReverbParams;
+    *p = *pParams;
+    p->m_DelayMs = Clamp(p->m_DelayMs, 1, MASTEREFFECTS_MAX_DELAY_MS);
+    p->m_Feedback = Clamp(p->m_Feedback, 0, 98);
+    p->m_Damping = Clamp(p->m_Damping, 0, 100);
+    p->m_Wet = Clamp(p->m_Wet, 0, 100);
+
+    FxReverb* r = &g_FxReverb;
+    bool resized = false;
+    for (int i = 0; i < REVERB_COMBS; i++)
+    {
+        int len = MsToFrames(p->m_DelayMs) * g_FxCombScale[i] / 1000;
+        if (len < 1)
+            len = 1;
+        resized |= len != r->m_Len[i];
+        r->m_Len[i] = len;
+    }
+    r->m_Feedback = p->m_Feedback * UNITY_Q15 / 100;
+    r->m_Damping = p->m_Damping * UNITY_Q15 / 100;
+    r->m_Wet = p->m_Wet * UNITY_Q15 / 100;
+
+    if (resized)
+        g_FxStages[MASTEREFFECT_REVERB].m_Restart = true;
+}
+
+void MasterEffectsSetLimiter(const MasterLimiterParams* pParams)
+{
+    // As for the compressor
+    if (!g_FxRate)
+        return;
+
+    MasterLimiterParams* p = &g_FxLimiterParams;
+    *p = *pParams;
+    p->m_CeilingDb = Clamp(p->m_CeilingDb, -24, 0);
+    p->m_LookaheadMs = Clamp(p->m_LookaheadMs, 0, 1000 * MASTEREFFECTS_MAX_LOOKAHEAD / g_FxRate);
+    p->m_ReleaseMs = Clamp(p->m_ReleaseMs, 1, 5000);
+
+    FxLimiter* l = &g_FxLimiter;
+    l->m_Ceiling = DbToGain(p->m_CeilingDb, 32767);
+    l->m_ReleaseCoef = TimeCoef(p->m_ReleaseMs);
+
+    int lookahead = Clamp(MsToFrames(p->m_LookaheadMs), 1, MASTEREFFECTS_MAX_LOOKAHEAD);
+    if (lookahead != l->m_Lookahead)
+    {
+        l->m_Lookahead = lookahead;
+        g_FxStages[MASTEREFFECT_LIMITER].m_Restart = true;
+    }
+}
+
+void MasterEffectsGetCompressor(MasterCompressorParams* pParams)
+{
+    *pParams = g_FxCompressorParams;
+}
+
+void MasterEffectsGetReverb(MasterReverbParams* pParams)
+{
+    *pParams = g_FxReverbParams;
+}
+
+void MasterEffectsGetLimiter(MasterLimiterParams* pParams)
+{
+    *pParams = g_FxLimiterParams;
+}
+
+void MasterEffectsProcess(int32* pAccum, int frames, int channels)
+{
+    for (int i = 0; i < MASTEREFFECT_STAGES; i++)
+    {
+        FxStage* s = &g_FxStages[i];
+        if (s->m_Bypass)
+        {
+            s->m_Running = false;
+            continue;
+        }
+
+        if (!s->m_Running || s->m_Restart)
+        {
+            s->m_Restart = false;
+            g_FxRestart[i]();
+            s->m_Running = true;
+        }
+        g_FxProcess[i](pAccum, frames, channels);
+    }
+}
+
+void MasterEffectsTerminate()
+{
+    for (int i = 0; i < MASTEREFFECT_STAGES; i++)
+    {
+        g_FxStages[i].m_Bypass = true;
+        g_FxStages[i].m_Running = false;
+        g_FxStages[i].m_Restart = false;
+    }
+
+    free(g_FxReverbMem);
+    g_FxReverbMem = NULL;
+    memset(g_FxReverb.m_pBuf, 0, sizeof(g_FxReverb.m_pBuf));
+    memset(g_FxReverb.m_Len, 0, sizeof(g_FxReverb.m_Len));
+    g_FxLimiter.m_Lookahead = 0;
+    g_FxRate = 0;
+}
@@ -0,0 +1,105 @@
+/*
+ * This file is part of the Marmalade SDK Code Samples.
+ *
+ * Copyright (C) 2001-2011 Ideaworks3D Ltd.
+ * All Rights Reserved.
+ *
+ * This source code is intended only as a supplement to Ideaworks Labs
+ * Development Tools and/or on-line documentation.
+ *
+ * THIS CODE AND INFORMATION ARE PROVIDED "AS IS" WITHOUT WARRANTY OF ANY
+ * KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+ * PARTICULAR PURPOSE.
+ */
+// Insert effects run on the software mixer's output before it is clipped
+//-----------------------------------------------------------------------------
+
+#ifndef MASTER_EFFECTS_H
+#define MASTER_EFFECTS_H
+
+#include "s3eTypes.h"
+
+// Longest limiter look-ahead, in frames
+#define MASTEREFFECTS_MAX_LOOKAHEAD 512
+
+// Longest reverb delay, in milliseconds
+#define MASTEREFFECTS_MAX_DELAY_MS  100
+
+/**
+ * Stages of the chain, in the order they are run. The limiter comes last
+ * so nothing after it can push the mix past its ceiling.
+ */
+typedef enum MasterEffectStage
+{
+    MASTEREFFECT_COMPRESSOR,
+    MASTEREFFECT_REVERB,
+    MASTEREFFECT_LIMITER,
+    MASTEREFFECT_STAGES
+} MasterEffectStage;
+
+typedef struct MasterCompressorParams
+{
+    int     m_ThresholdDb;      // level compression starts at, dB below full scale (default -12)
+    int     m_Ratio;            // input dB over the threshold per output dB (default 4)
+    int     m_AttackMs;         // default 5
+    int     m_ReleaseMs;        // default 100
+    int     m_MakeupDb;         // gain after compression (default 0)
+} MasterCompressorParams;
+
+typedef struct MasterReverbParams
+{
+    int     m_DelayMs;          // longest comb delay, up to MASTEREFFECTS_MAX_DELAY_MS (default 40)
+    int     m_Feedback;         // percent fed back each pass; sets the tail length (default 70)
+    int     m_Damping;          // percent of the high end lost each pass (default 30)
+    int     m_Wet;              // percent of reverb added to the mix (default 20)
+} MasterReverbParams;
+
+typedef struct MasterLimiterParams
+{
+    int     m_CeilingDb;        // highest output peak, dB below full scale (default -1)
+    int     m_LookaheadMs;      // output delay the gain is lowered over (default 2)
+    int     m_ReleaseMs;        // default 80
+} MasterLimiterParams;
+
+/**
+ * Allocate the chain for output at @a sampleRate, with every stage
+ * bypassed and default settings. Main thread only.
+ */
+bool MasterEffectsInit(uint32 sampleRate);
+
+/**
+ * Switch a stage in or out. A bypassed stage costs a single test per block
+ * and keeps no state; it starts from silence when switched back in.
+ * Takes effect from the next block.
+ */
+void MasterEffectsSetBypass(MasterEffectStage stage, bool bypass);
+bool MasterEffectsIsBypassed(MasterEffectStage stage);
+
+/**
+ * Change a stage's settings. Out of range values are clamped. Take effect
+ * from the next block; a new reverb delay or limiter look-ahead restarts
+ * that stage. Ignored before MasterEffectsInit() and after
+ * MasterEffectsTerminate().
+ */
+void MasterEffectsSetCompressor(const MasterCompressorParams* pParams);
+void MasterEffectsSetReverb(const MasterReverbParams* pParams);
+void MasterEffectsSetLimiter(const MasterLimiterParams* pParams);
+
+void MasterEffectsGetCompressor(MasterCompressorParams* pParams);
+void MasterEffectsGetReverb(MasterReverbParams* pParams);
+void MasterEffectsGetLimiter(MasterLimiterParams* pParams);
+
+/**
+ * Run every stage that is switched in over @a frames frames of the mix
+ * accumulator, interleaved if @a channels is 2. Samples are 16 bit full
+ * scale with headroom above. Audio callback only.
+ */
+void MasterEffectsProcess(int32* pAccum, int frames, int channels);
+
+/**
+ * Free the chain. Only once the audio callback has stopped.
+ */
+void MasterEffectsTerminate();
+
+#endif /* !MASTER_EFFECTS_H */
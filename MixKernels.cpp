@@ -0,0 +1,358 @@
+/*
+ * This file is part of the Marmalade SDK Code Samples.
+ *
+ * Copyright (C) 2001-2011 Ideaworks3D Ltd.
+ * All Rights Reserved.
+ *
+ * This source code is intended only as a supplement to Ideaworks Labs
+ * Development Tools and/or on-line documentation.
+ *
+ * THIS CODE AND INFORMATION ARE PROVIDED "AS IS" WITHOUT WARRANTY OF ANY
+ * KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+ * PARTICULAR PURPOSE.
+ */
+#include "MixKernels.h"
+#include "s3eDebug.h"
+#include <memory.h>
+#include <stdlib.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MIXKERNELS_SSE2 1
+#include <emmintrin.h>
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+#define MIXKERNELS_NEON 1
+#include <arm_neon.h>
+#endif
+
+// As in SampleConvert.cpp, each kernel runs its vector loop and finishes the
+// remainder with the scalar reference.
+
+static inline int16 Saturate(int32 s)
+{
+    return (int16)(s > 32767 ? 32767 : s < -32768 ? -32768 : s);
+}
+
+void MixMonoToMonoScalar(const int16* pSrc, int32* pAccum, int frames, int32 gain)
+{
+    for (int i = 0; i < frames; i++)
+        pAccum[i] += (pSrc[i] * gain) >> 8;
+}
+
+void MixMonoToMonoRampScalar(const int16* pSrc, int32* pAccum, int frames, int32 gain16, int32 step16)
+{
+    for (int i = 0; i < frames; i++, gain16 += step16)
+        pAccum[i] += (pSrc[i] * (gain16 >> 8)) >> 8;
+}
+
+void MixMonoToStereoScalar(const int16* pSrc, int32* pAccum, int frames, int32 gainL, int32 gainR)
+{
+    for (int i = 0; i < frames; i++)
+    {
+        pAccum[i*2] += (pSrc[i] * gainL) >> 8;
+        pAccum[i*2 + 1] += (pSrc[i] * gainR) >> 8;
+    }
+}
+
+void MixMonoToStereoRampScalar(const int16* pSrc, int32* pAccum, int frames,
+    int32 gainL16, int32 stepL16, int32 gainR16, int32 stepR16)
+{
+    for (int i = 0; i < frames; i++, gainL16 += stepL16, gainR16 += stepR16)
+    {
+        pAccum[i*2] += (pSrc[i] * (gainL16 >> 8)) >> 8;
+        pAccum[i*2 + 1] += (pSrc[i] * (gainR16 >> 8)) >> 8;
+    }
+}
+
+void MixClipScalar(const int32* pAccum, int16* pDst, int count, bool add)
+{
+    if (add)
+    {
+        for (int i = 0; i < count; i++)
+            pDst[i] = Saturate(pAccum[i] + pDst[i]);
+    }
+    else
+    {
+        for (int i = 0; i < count; i++)
+            pDst[i] = Saturate(pAccum[i]);
+    }
+}
+
+#if defined(MIXKERNELS_SSE2)
+// Full 32 bit products of eight samples and a gain, shifted down by 8
+static inline void MulGain(__m128i s, __m128i gain, __m128i* pLo, __m128i* pHi)
+{
+    __m128i lo = _mm_mullo_epi16(s, gain);
+    __m128i hi = _mm_mulhi_epi16(s, gain);
+    *pLo = _mm_srai_epi32(_mm_unpacklo_epi16(lo, hi), 8);
+    *pHi = _mm_srai_epi32(_mm_unpackhi_epi16(lo, hi), 8);
+}
+
+static inline void AddTo(int32* p, __m128i v)
+{
+    _mm_storeu_si128((__m128i*)p, _mm_add_epi32(_mm_loadu_si128((const __m128i*)p), v));
+}
+#endif
+
+void MixMonoToMono(const int16* pSrc, int32* pAccum, int frames, int32 gain)
+{
+    int i = 0;
+#if defined(MIXKERNELS_SSE2)
+    const __m128i g = _mm_set1_epi16((int16)gain);
+    for (; i + 8 <= frames; i += 8)
+    {
+        __m128i lo, hi;
+        MulGain(_mm_loadu_si128((const __m128i*)(pSrc + i)), g, &lo, &hi);
+        AddTo(pAccum + i, lo);
+        AddTo(pAccum + i + 4, hi);
+    }
+#elif defined(MIXKERNELS_NEON)
+    const int16 g = (int16)gain;
+    for (; i + 8 <= frames; i += 8)
+    {
+        int16x8_t s = vld1q_s16(pSrc + i);
+        int32x4_t lo = vshrq_n_s32(vmull_n_s16(vget_low_s16(s), g), 8);
+        int32x4_t hi = vshrq_n_s32(vmull_n_s16(vget_high_s16(s), g), 8);
+        vst1q_s32(pAccum + i, vaddq_s32(vld1q_s32(pAccum + i), lo));
+        vst1q_s32(pAccum + i + 4, vaddq_s32(vld1q_s32(pAccum + i + 4), hi));
+    }
+#endif
+    MixMonoToMonoScalar(pSrc + i, pAccum + i, frames - i, gain);
+}
+
+void MixMonoToMonoRamp(const int16* pSrc, int32* pAccum, int frames, int32 gain16, int32 step16)
+{
+    int i = 0;
+#if defined(MIXKERNELS_SSE2)
+    // Eight running gains, one per lane, narrowed to 16 bits for the multiply
+    __m128i g0 = _mm_set_epi32(gain16 + 3 * step16, gain16 + 2 * step16, gain16 + step16, gain16);
+    __m128i g1 = _mm_add_epi32(g0, _mm_set1_epi32(4 * step16));
+    const __m128i step8 = _mm_set1_epi32(8 * step16);
+    for (; i + 8 <= frames; i += 8)
+    {
+        __m128i g = _mm_packs_epi32(_mm_srai_epi32(g0, 8), _mm_srai_epi32(g1, 8));
+        __m128i lo, hi;
+        MulGain(_mm_loadu_si128((const __m128i*)(pSrc + i)), g, &lo, &hi);
+        AddTo(pAccum + i, lo);
+        AddTo(pAccum + i + 4, hi);
+        g0 = _mm_add_epi32(g0, step8);
+        g1 = _mm_add_epi32(g1, step8);
+    }
+#elif defined(MIXKERNELS_NEON)
+    int32 lanes[4] = { gain16, gain16 + step16, gain16 + 2 * step16, gain16 + 3 * step16 };
+    int32x4_t g = vld1q_s32(lanes);
+    const int32x4_t step4 = vdupq_n_s32(4 * step16);
+    for (; i + 4 <= frames; i += 4)
+    {
+        int16x4_t gain = vmovn_s32(vshrq_n_s32(g, 8));
+        int32x4_t p = vshrq_n_s32(vmull_s16(vld1_s16(pSrc + i), gain), 8);
+        vst1q_s32(pAccum + i, vaddq_s32(vld1q_s32(pAccum + i), p));
+        g = vaddq_s32(g, step4);
+    }
+#endif
+    MixMonoToMonoRampScalar(pSrc + i, pAccum + i, frames - i, gain16 + i * step16, step16);
+}
+
+void MixMonoToStereo(const int16* pSrc, int32* pAccum, int frames, int32 gainL, int32 gainR)
+{
+    int i = 0;
+#if defined(MIXKERNELS_SSE2)
+    const __m128i gl = _mm_set1_epi16((int16)gainL);
+    const __m128i gr = _mm_set1_epi16((int16)gainR);
+    for (; i + 8 <= frames; i += 8)
+    {
+        __m128i s = _mm_loadu_si128((const __m128i*)(pSrc + i));
+        __m128i l0, l1, r0, r1;
+        MulGain(s, gl, &l0, &l1);
+        MulGain(s, gr, &r0, &r1);
+
+        int32* p = pAccum + i*2;
+        AddTo(p, _mm_unpacklo_epi32(l0, r0));
+        AddTo(p + 4, _mm_unpackhi_epi32(l0, r0));
+        AddTo(p + 8, _mm_unpacklo_epi32(l1, r1));
+        AddTo(p + 12, _mm_unpackhi_epi32(l1, r1));
+    }
+#elif defined(MIXKERNELS_NEON)
+    const int16 gl = (int16)gainL;
+    const int16 gr = (int16)gainR;
+    for (; i + 4 <= frames; i += 4)
+    {
+        int16x4_t s = vld1_s16(pSrc + i);
+        int32x4x2_t lr = vld2q_s32(pAccum + i*2);
+        lr.val[0] = vaddq_s32(lr.val[0], vshrq_n_s32(vmull_n_s16(s, gl), 8));
+        lr.val[1] = vaddq_s32(lr.val[1], vshrq_n_s32(vmull_n_s16(s, gr), 8));
+        vst2q_s32(pAccum + i*2, lr);
+    }
+#endif
+    MixMonoToStereoScalar(pSrc + i, pAccum + i*2, frames - i, gainL, gainR);
+}
+
+void MixMonoToStereoRamp(const int16* pSrc, int32* pAccum, int frames,
+    int32 gainL16, int32 stepL16, int32 gainR16, int32 stepR16)
+{
+    int i = 0;
+#if defined(MIXKERNELS_SSE2)
+    __m128i l0 = _mm_set_epi32(gainL16 + 3 * stepL16, gainL16 + 2 * stepL16, gainL16 + stepL16, gainL16);
+    __m128i r0 = _mm_set_epi32(gainR16 + 3 * stepR16, gainR16 + 2 * stepR16, gainR16 + stepR16, gainR16);
+    __m128i l1 = _mm_add_epi32(l0, _mm_set1_epi32(4 * stepL16));
+    __m128i r1 = _mm_add_epi32(r0, _mm_set1_epi32(4 * stepR16));
+    const __m128i stepL8 = _mm_set1_epi32(8 * stepL16);
+    const __m128i stepR8 = _mm_set1_epi32(8 * stepR16);
+    for (; i + 8 <= frames; i += 8)
+    {
+        __m128i s = _mm_loadu_si128((const __m128i*)(pSrc + i));
+        __m128i pl0, pl1, pr0, pr1;
+        MulGain(s, _mm_packs_epi32(_mm_srai_epi32(l0, 8), _mm_srai_epi32(l1, 8)), &pl0, &pl1);
+        MulGain(s, _mm_packs_epi32(_mm_srai_epi32(r0, 8), _mm_srai_epi32(r1, 8)), &pr0, &pr1);
+
+        int32* p = pAccum + i*2;
+        AddTo(p, _mm_unpacklo_epi32(pl0, pr0));
+        AddTo(p + 4, _mm_unpackhi_epi32(pl0, pr0));
+        AddTo(p + 8, _mm_unpacklo_epi32(pl1, pr1));
+        AddTo(p + 12, _mm_unpackhi_epi32(pl1, pr1));
+
+        l0 = _mm_add_epi32(l0, stepL8);
+        l1 = _mm_add_epi32(l1, stepL8);
+        r0 = _mm_add_epi32(r0, stepR8);
+        r1 = _mm_add_epi32(r1, stepR8);
+    }
+#elif defined(MIXKERNELS_NEON)
+    int32 lanesL[4] = { gainL16, gainL16 + stepL16, gainL16 + 2 * stepL16, gainL16 + 3 * stepL16 };
+    int32 lanesR[4] = { gainR16, gainR16 + stepR16, gainR16 + 2 * stepR16, gainR16 + 3 * stepR16 };
+    int32x4_t gl = vld1q_s32(lanesL);
+    int32x4_t gr = vld1q_s32(lanesR);
+    const int32x4_t stepL4 = vdupq_n_s32(4 * stepL16);
+    const int32x4_t stepR4 = vdupq_n_s32(4 * stepR16);
+    for (; i + 4 <= frames; i += 4)
+    {
+        int16x4_t s = vld1_s16(pSrc + i);
+        int32x4x2_t lr = vld2q_s32(pAccum + i*2);
+        lr.val[0] = vaddq_s32(lr.val[0], vshrq_n_s32(vmull_s16(s, vmovn_s32(vshrq_n_s32(gl, 8))), 8));
+        lr.val[1] = vaddq_s32(lr.val[1], vshrq_n_s32(vmull_s16(s, vmovn_s32(vshrq_n_s32(gr, 8))), 8));
+        vst2q_s32(pAccum + i*2, lr);
+        gl = vaddq_s32(gl, stepL4);
+        gr = vaddq_s32(gr, stepR4);
+    }
+#endif
+    MixMonoToStereoRampScalar(pSrc + i, pAccum + i*2, frames - i,
+        gainL16 + i * stepL16, stepL16, gainR16 + i * stepR16, stepR16);
+}
+
+void MixClip(const int32* pAccum, int16* pDst, int count, bool add)
+{
+    int i = 0;
+#if defined(MIXKERNELS_SSE2)
+    for (; i + 8 <= count; i += 8)
+    {
+        __m128i a = _mm_loadu_si128((const __m128i*)(pAccum + i));
+        __m128i b = _mm_loadu_si128((const __m128i*)(pAccum + i + 4));
+        if (add)
+        {
+            // Sign extend the existing output to 32 bits before adding
+            __m128i d = _mm_loadu_si128((const __m128i*)(pDst + i));
+            a = _mm_add_epi32(a, _mm_srai_epi32(_mm_unpacklo_epi16(d, d), 16));
+            b = _mm_add_epi32(b, _mm_srai_epi32(_mm_unpackhi_epi16(d, d), 16));
+        }
+        _mm_storeu_si128((__m128i*)(pDst + i), _mm_packs_epi32(a, b));
+    }
+#elif defined(MIXKERNELS_NEON)
+    for (; i + 8 <= count; i += 8)
+    {
+        int32x4_t a = vld1q_s32(pAccum + i);
+        int32x4_t b = vld1q_s32(pAccum + i + 4);
+        if (add)
+        {
+            int16x8_t d = vld1q_s16(pDst + i);
+            a = vaddw_s16(a, vget_low_s16(d));
+            b = vaddw_s16(b, vget_high_s16(d));
+        }
+        vst1q_s16(pDst + i, vcombine_s16(vqmovn_s32(a), vqmovn_s32(b)));
+    }
+#endif
+    MixClipScalar(pAccum + i, pDst + i, count - i, add);
+}
+
+const char* MixKernelsTarget()
+{
+#if defined(MIXKERNELS_SSE2)
+    return "sse2";
+#elif defined(MIXKERNELS_NEON)
+    return "neon";
+#else
+    return "scalar";
+#endif
+}
+
+//-----------------------------------------------------------------------------
+// Self test
+//-----------------------------------------------------------------------------
+#define SELFTEST_FRAMES 259     // not a multiple of any vector width
+
+static int16 RandomSample()
+{
+    // Bias towards the extremes, where saturation and rounding differ
+    switch (rand() & 7)
+    {
+    case 0:
+        return 32767;
+    case 1:
+        return -32768;
+    default:
+        return (int16)((rand() & 0xff) | ((rand() & 0xff) << 8));
+    }
+}
+
+bool MixKernelsSelfTest()
+{
+    static const int32 gains[] = { 0, 1, 0x7f, 0x80, 0xb5, 0xff, 0x100, 0x7fff };
+    int16 src[SELFTEST_FRAMES];
+    int16 dst[2][SELFTEST_FRAMES * 2];
+    int32 accum[2][SELFTEST_FRAMES * 2];
+    bool ok = true;
+
+    srand(2);
+    for (int t = 0; t < 64 && ok; t++)
+    {
+        int frames = t < 16 ? t : SELFTEST_FRAMES - (t & 7);
+        int32 gainL = gains[t % 8];
+        int32 gainR = gains[(t / 8) % 8];
+
+        for (int i = 0; i < SELFTEST_FRAMES; i++)
+            src[i] = RandomSample();
+        for (int i = 0; i < SELFTEST_FRAMES * 2; i++)
+            accum[0][i] = accum[1][i] = ((rand() & 0xfff) << 8) - 0x80000;
+
+        MixMonoToMonoScalar(src, accum[0], frames, gainL);
+        MixMonoToMono(src, accum[1], frames, gainL);
+        ok &= !memcmp(accum[0], accum[1], sizeof(accum[0]));
+
+        // Ramp between the two gains over the block
+        int32 step16 = frames ? ((gainR - gainL) << 8) / frames : 0;
+        MixMonoToMonoRampScalar(src, accum[0], frames, gainL << 8, step16);
+        MixMonoToMonoRamp(src, accum[1], frames, gainL << 8, step16);
+        ok &= !memcmp(accum[0], accum[1], sizeof(accum[0]));
+
+        MixMonoToStereoScalar(src, accum[0], frames, gainL, gainR);
+        MixMonoToStereo(src, accum[1], frames, gainL, gainR);
+        ok &= !memcmp(accum[0], accum[1], sizeof(accum[0]));
+
+        // Sides ramping in opposite directions, as in a pan
+        MixMonoToStereoRampScalar(src, accum[0], frames, gainL << 8, step16, gainR << 8, -step16 / 2);
+        MixMonoToStereoRamp(src, accum[1], frames, gainL << 8, step16, gainR << 8, -step16 / 2);
+        ok &= !memcmp(accum[0], accum[1], sizeof(accum[0]));
+
+        for (int add = 0; add < 2; add++)
+        {
+            for (int i = 0; i < SELFTEST_FRAMES * 2; i++)
+                dst[0][i] = dst[1][i] = RandomSample();
+            MixClipScalar(accum[0], dst[0], frames * 2, add != 0);
+            MixClip(accum[1], dst[1], frames * 2, add != 0);
+            ok &= !memcmp(dst[0], dst[1], sizeof(dst[0]));
+        }
+
+        if (!ok)
+            s3eDebugTracePrintf("mix kernels: %s differs from scalar (frames %d, gains %d %d)",
+                MixKernelsTarget(), frames, gainL, gainR);
+    }
+    return ok;
+}
@@ -0,0 +1,68 @@
+/*
+ * This file is part of the Marmalade SDK Code Samples.
+ *
+ * Copyright (C) 2001-2011 Ideaworks3D Ltd.
+ * All Rights Reserved.
+ *
+ * This source code is intended only as a supplement to Ideaworks Labs
+ * Development Tools and/or on-line documentation.
+ *
+ * THIS CODE AND INFORMATION ARE PROVIDED "AS IS" WITHOUT WARRANTY OF ANY
+ * KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+ * PARTICULAR PURPOSE.
+ */
+// Accumulate and saturate kernels used by the software mixer
+//-----------------------------------------------------------------------------
+
+#ifndef MIX_KERNELS_H
+#define MIX_KERNELS_H
+
+#include "s3eTypes.h"
+
+// Gains are .8 fixed point: 0x100 (SOUNDMIXER_MAX_VOLUME) leaves a sample
+// unchanged. Any gain from 0 to 0x7fff is allowed. Each product is
+// (sample * gain) >> 8, rounded towards minus infinity.
+//
+// The plain kernels use SSE2 or NEON where the target has it; the Scalar
+// versions are the reference they must match bit for bit.
+
+// pAccum[i] += pSrc[i] * gain
+void MixMonoToMono(const int16* pSrc, int32* pAccum, int frames, int32 gain);
+
+// As MixMonoToMono with a gain that changes every frame. @a gain16 and
+// @a step16 are .16 fixed point (gain << 8); frame i is mixed with gain
+// (gain16 + i * step16) >> 8, which must stay within 0 to 0x7fff.
+void MixMonoToMonoRamp(const int16* pSrc, int32* pAccum, int frames, int32 gain16, int32 step16);
+
+// Interleaved stereo pAccum: left += pSrc[i] * gainL, right += pSrc[i] * gainR
+void MixMonoToStereo(const int16* pSrc, int32* pAccum, int frames, int32 gainL, int32 gainR);
+
+// Stereo MixMonoToMonoRamp: each side has its own .16 gain and step
+void MixMonoToStereoRamp(const int16* pSrc, int32* pAccum, int frames,
+    int32 gainL16, int32 stepL16, int32 gainR16, int32 stepR16);
+
+// pDst[i] = saturate(pAccum[i]), or saturate(pDst[i] + pAccum[i]) if @a add
+void MixClip(const int32* pAccum, int16* pDst, int count, bool add);
+
+void MixMonoToMonoScalar(const int16* pSrc, int32* pAccum, int frames, int32 gain);
+void MixMonoToMonoRampScalar(const int16* pSrc, int32* pAccum, int frames, int32 gain16, int32 step16);
+void MixMonoToStereoScalar(const int16* pSrc, int32* pAccum, int frames, int32 gainL, int32 gainR);
+void MixMonoToStereoRampScalar(const int16* pSrc, int32* pAccum, int frames,
+    int32 gainL16, int32 stepL16, int32 gainR16, int32 stepR16);
+void MixClipScalar(const int32* pAccum, int16* pDst, int count, bool add);
+
+/**
+ * Name of the vector unit the kernels were built for: "sse2", "neon" or
+ * "scalar".
+ */
+const char* MixKernelsTarget();
+
+/**
+ * Run every kernel against its scalar reference on random data, including
+ * odd lengths and extreme values.
+ * @return true if all results are identical.
+ */
+bool MixKernelsSelfTest();
+
+#endif /* !MIX_KERNELS_H */
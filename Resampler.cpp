@@ -0,0 +1,440 @@
+/*
+ * This file is part of the Marmalade SDK Code Samples.
+ *
+ * Copyright (C) 2001-2011 Ideaworks3D Ltd.
+ * All Rights Reserved.
+ *
+ * This source code is intended only as a supplement to Ideaworks Labs
+ * Development Tools and/or on-line documentation.
+ *
+ * THIS CODE AND INFORMATION ARE PROVIDED "AS IS" WITHOUT WARRANTY OF ANY
+ * KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+ * PARTICULAR PURPOSE.
+ */
+#include "Resampler.h"
+#include "s3eDebug.h"
+#include <malloc.h>
+#include <memory.h>
+#include <math.h>
+#include <stdlib.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define RESAMPLER_SSE2 1
+#include <emmintrin.h>
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+#define RESAMPLER_NEON 1
+#include <arm_neon.h>
+#endif
+
+#if RESAMPLER_TAPS != 16
+#error the vector dot products assume 16 taps
+#endif
+
+// Frames of history before the output position, and after it, that the
+// sinc filter reads
+#define RESAMPLER_HISTORY       (RESAMPLER_TAPS / 2 - 1)
+#define RESAMPLER_LOOKAHEAD     (RESAMPLER_TAPS / 2)
+
+// Passband edge as a fraction of the lower Nyquist rate, in 1/256ths
+#define RESAMPLER_CUTOFF        232
+
+#define RESAMPLER_COEF_BITS     14
+
+// Distinct ratios ResamplerGetFilter() keeps filters for
+#define RESAMPLER_MAX_FILTERS   8
+
+static ResamplerFilter g_ResamplerFilters[RESAMPLER_MAX_FILTERS];
+static int g_ResamplerNumFilters = 0;
+
+static inline int16 Saturate(int32 s)
+{
+    return (int16)(s > 32767 ? 32767 : s < -32768 ? -32768 : s);
+}
+
+static uint32 Step(uint32 inRate, uint32 outRate)
+{
+    uint64 step = ((uint64)inRate << 16) / outRate;
+    if (step > RESAMPLER_MAX_STEP << 16)
+    {
+        s3eDebugTracePrintf("resampler: %u Hz to %u Hz is beyond the supported ratio", inRate, outRate);
+        step = RESAMPLER_MAX_STEP << 16;
+    }
+    return step ? (uint32)step : 1;
+}
+
+static uint32 Cutoff(uint32 inRate, uint32 outRate)
+{
+    uint32 cutoff = RESAMPLER_CUTOFF;
+    if (outRate < inRate)
+        cutoff = (uint32)((uint64)cutoff * outRate / inRate);
+    return cutoff ? cutoff : 1;
+}
+
+//-----------------------------------------------------------------------------
+// Filters
+//-----------------------------------------------------------------------------
+void ResamplerBuildFilter(ResamplerFilter* pFilter, uint32 inRate, uint32 outRate)
+{
+    const double pi = 3.14159265358979323846;
+    pFilter->m_Cutoff = Cutoff(inRate, outRate);
+    double fc = pFilter->m_Cutoff / 256.0;
+
+    for (int p = 0; p < RESAMPLER_PHASES; p++)
+    {
+        double taps[RESAMPLER_TAPS];
+        double sum = 0;
+        for (int k = 0; k < RESAMPLER_TAPS; k++)
+        {
+            // Distance in source frames from the output position to the
+            // frame this tap weights, Blackman windowed across the filter
+            double t = k - RESAMPLER_HISTORY - (double)p / RESAMPLER_PHASES;
+            double x = pi * fc * t;
+            double sinc = x == 0 ? 1.0 : sin(x) / x;
+            double w = 0.42 + 0.5 * cos(2 * pi * t / RESAMPLER_TAPS) + 0.08 * cos(4 * pi * t / RESAMPLER_TAPS);
+            taps[k] = sinc * w;
+            sum += taps[k];
+        }
+
+        // Normalise for unity gain at DC, putting the rounding error into
+        // the tap nearest the output position
+        int32 total = 0;
+        for (int k = 0; k < RESAMPLER_TAPS; k++)
+        {
+            int16 c = (int16)floor(taps[k] / sum * (1 << RESAMPLER_COEF_BITS) + 0.5);
+            pFilter->m_Coefs[p][k] = c;
+            total += c;
+        }
+        int centre = p < RESAMPLER_PHASES / 2 ? RESAMPLER_HISTORY : RESAMPLER_HISTORY + 1;
+        pFilter->m_Coefs[p][centre] += (int16)((1 << RESAMPLER_COEF_BITS) - total);
+    }
+}
+
+const ResamplerFilter* ResamplerGetFilter(uint32 inRate, uint32 outRate)
+{
+    uint32 cutoff = Cutoff(inRate, outRate);
+    for (int i = 0; i < g_ResamplerNumFilters; i++)
+    {
+        if (g_ResamplerFilters[i].m_Cutoff == cutoff)
+            return &g_ResamplerFilters[i];
+    }
+
+    if (g_ResamplerNumFilters == RESAMPLER_MAX_FILTERS)
+    {
+        s3eDebugTracePrintf("resampler: no filter for %u Hz to %u Hz, using linear", inRate, outRate);
+        return NULL;
+    }
+
+    ResamplerFilter* pFilter = &g_ResamplerFilters[g_ResamplerNumFilters++];
+    ResamplerBuildFilter(pFilter, inRate, outRate);
+    return pFilter;
+}
+
+void ResamplerTerminate()
+{
+    g_ResamplerNumFilters = 0;
+}
+
+//-----------------------------------------------------------------------------
+// Streaming
+//-----------------------------------------------------------------------------
+void ResamplerInit(Resampler* pResampler, uint32 inRate, uint32 outRate,
+    ResamplerQuality quality, const ResamplerFilter* pFilter)
+{
+    pResampler->m_pFilter = pFilter;
+    pResampler->m_BaseStep = Step(inRate, outRate);
+    pResampler->m_Step = pResampler->m_BaseStep;
+    pResampler->m_Frac = 0;
+    ResamplerSetQuality(pResampler, quality);
+
+    // The first output lines up with the first source frame, with silence
+    // before it
+    memset(pResampler->m_Buf, 0, RESAMPLER_HISTORY * sizeof(int16));
+    pResampler->m_Pos = RESAMPLER_HISTORY;
+    pResampler->m_Have = RESAMPLER_HISTORY;
+}
+
+void ResamplerSetQuality(Resampler* pResampler, ResamplerQuality quality)
+{
+    // Both qualities keep the same history, so switching is seamless
+    pResampler->m_Quality = pResampler->m_pFilter ? quality : RESAMPLER_LINEAR;
+}
+
+void ResamplerSetRate(Resampler* pResampler, uint32 rate)
+{
+    uint64 step = ((uint64)pResampler->m_BaseStep * rate) >> 16;
+    if (step > RESAMPLER_MAX_STEP << 16)
+        step = RESAMPLER_MAX_STEP << 16;
+    pResampler->m_Step = step ? (uint32)step : 1;
+}
+
+static inline int Lookahead(const Resampler* pResampler)
+{
+    return pResampler->m_Quality == RESAMPLER_SINC ? RESAMPLER_LOOKAHEAD : 1;
+}
+
+// Frames at the start of the buffer that are no longer needed
+static inline int Consumed(const Resampler* pResampler)
+{
+    int consumed = pResampler->m_Pos - RESAMPLER_HISTORY;
+    return consumed < pResampler->m_Have ? consumed : pResampler->m_Have;
+}
+
+int ResamplerNeeded(const Resampler* pResampler, int outFrames)
+{
+    if (outFrames <= 0)
+        return 0;
+
+    uint64 last = pResampler->m_Frac + (uint64)(outFrames - 1) * pResampler->m_Step;
+    int64 need = pResampler->m_Pos + (int64)(last >> 16) + Lookahead(pResampler) + 1 - pResampler->m_Have;
+    if (need <= 0)
+        return 0;
+
+    int space = RESAMPLER_BUFFER_FRAMES - (pResampler->m_Have - Consumed(pResampler));
+    return need < space ? (int)need : space;
+}
+
+static void Append(Resampler* pResampler, const int16* pSrc, int frames)
+{
+    if (pResampler->m_Have + frames > RESAMPLER_BUFFER_FRAMES)
+    {
+        // Slide what is still needed down to the start. If the position
+        // has stepped past the end, frames still to come are skipped too.
+        int consumed = Consumed(pResampler);
+        memmove(pResampler->m_Buf, pResampler->m_Buf + consumed, (pResampler->m_Have - consumed) * sizeof(int16));
+        pResampler->m_Have -= consumed;
+        pResampler->m_Pos -= consumed;
+    }
+
+    if (pSrc)
+        memcpy(pResampler->m_Buf + pResampler->m_Have, pSrc, frames * sizeof(int16));
+    else
+        memset(pResampler->m_Buf + pResampler->m_Have, 0, frames * sizeof(int16));
+    pResampler->m_Have += frames;
+}
+
+void ResamplerWrite(Resampler* pResampler, const int16* pSrc, int frames)
+{
+    Append(pResampler, pSrc, frames);
+}
+
+void ResamplerFlush(Resampler* pResampler)
+{
+    // Enough silence for the filter to reach the last source frame
+    Append(pResampler, NULL, Lookahead(pResampler));
+}
+
+static inline void Advance(Resampler* pResampler)
+{
+    pResampler->m_Frac += pResampler->m_Step;
+    pResampler->m_Pos += pResampler->m_Frac >> 16;
+    pResampler->m_Frac &= 0xffff;
+}
+
+static int ReadLinear(Resampler* pResampler, int16* pDst, int frames)
+{
+    int done = 0;
+    while (done < frames && pResampler->m_Pos + 1 < pResampler->m_Have)
+    {
+        const int16* p = pResampler->m_Buf + pResampler->m_Pos;
+        pDst[done++] = (int16)(p[0] + (((p[1] - p[0]) * (int32)(pResampler->m_Frac >> 1)) >> 15));
+        Advance(pResampler);
+    }
+    return done;
+}
+
+// Sum of RESAMPLER_TAPS products. The coefficients are normalised, so the
+// total cannot overflow.
+static inline int32 DotScalar(const int16* pSrc, const int16* pCoefs)
+{
+    int32 sum = 0;
+    for (int k = 0; k < RESAMPLER_TAPS; k++)
+        sum += pSrc[k] * pCoefs[k];
+    return sum;
+}
+
+static inline int32 Dot(const int16* pSrc, const int16* pCoefs)
+{
+#if defined(RESAMPLER_SSE2)
+    __m128i a = _mm_madd_epi16(_mm_loadu_si128((const __m128i*)pSrc), _mm_loadu_si128((const __m128i*)pCoefs));
+    __m128i b = _mm_madd_epi16(_mm_loadu_si128((const __m128i*)(pSrc + 8)), _mm_loadu_si128((const __m128i*)(pCoefs + 8)));
+    __m128i s = _mm_add_epi32(a, b);
+    s = _mm_add_epi32(s, _mm_shuffle_epi32(s, _MM_SHUFFLE(1, 0, 3, 2)));
+    s = _mm_add_epi32(s, _mm_shuffle_epi32(s, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtsi128_si32(s);
+#elif defined(RESAMPLER_NEON)
+    int32x4_t s = vmull_s16(vld1_s16(pSrc), vld1_s16(pCoefs));
+    s = vmlal_s16(s, vld1_s16(pSrc + 4), vld1_s16(pCoefs + 4));
+    s = vmlal_s16(s, vld1_s16(pSrc + 8), vld1_s16(pCoefs + 8));
+    s = vmlal_s16(s, vld1_s16(pSrc + 12), vld1_s16(pCoefs + 12));
+    int32x2_t h = vadd_s32(vget_low_s32(s), vget_high_s32(s));
+    return vget_lane_s32(vpadd_s32(h, h), 0);
+#else
+    return DotScalar(pSrc, pCoefs);
+#endif
+}
+
+typedef int32 (*DotFn)(const int16* pSrc, const int16* pCoefs);
+
+static inline int ReadSinc(Resampler* pResampler, int16* pDst, int frames, DotFn dot)
+{
+    const int16 (*pCoefs)[RESAMPLER_TAPS] = pResampler->m_pFilter->m_Coefs;
+    const int round = 1 << (RESAMPLER_COEF_BITS - 1);
+
+    int done = 0;
+    while (done < frames && pResampler->m_Pos + RESAMPLER_LOOKAHEAD < pResampler->m_Have)
+    {
+        const int16* pSrc = pResampler->m_Buf + pResampler->m_Pos - RESAMPLER_HISTORY;
+        int32 sum = dot(pSrc, pCoefs[pResampler->m_Frac >> (16 - RESAMPLER_PHASE_BITS)]);
+        pDst[done++] = Saturate((sum + round) >> RESAMPLER_COEF_BITS);
+        Advance(pResampler);
+    }
+    return done;
+}
+
+int ResamplerRead(Resampler* pResampler, int16* pDst, int frames)
+{
+    if (pResampler->m_Quality == RESAMPLER_SINC)
+        return ReadSinc(pResampler, pDst, frames, Dot);
+    return ReadLinear(pResampler, pDst, frames);
+}
+
+int ResamplerReadScalar(Resampler* pResampler, int16* pDst, int frames)
+{
+    if (pResampler->m_Quality == RESAMPLER_SINC)
+        return ReadSinc(pResampler, pDst, frames, DotScalar);
+    return ReadLinear(pResampler, pDst, frames);
+}
+
+//-----------------------------------------------------------------------------
+// Load time conversion
+//-----------------------------------------------------------------------------
+bool ResamplerConvertSample(SoundSample* pSample, uint32 outRate, ResamplerQuality quality)
+{
+    if (pSample->m_Codec != SOUNDSAMPLE_CODEC_PCM || !pSample->m_Data || !pSample->m_SampleRate || !outRate)
+        return false;
+    if (pSample->m_SampleRate == outRate)
+        return true;
+
+    uint32 inRate = pSample->m_SampleRate;
+    uint32 inFrames = pSample->m_DataLen / sizeof(int16);
+    uint32 maxFrames = (uint32)(((uint64)inFrames << 16) / Step(inRate, outRate)) + 2;
+
+    Resampler* pResampler = (Resampler*)malloc(sizeof(Resampler));
+    ResamplerFilter* pFilter = (ResamplerFilter*)malloc(sizeof(ResamplerFilter));
+    int16* pOut = (int16*)malloc(maxFrames * sizeof(int16));
+    if (!pResampler || !pFilter || !pOut)
+    {
+        free(pResampler);
+        free(pFilter);
+        free(pOut);
+        return false;
+    }
+
+    ResamplerBuildFilter(pFilter, inRate, outRate);
+    ResamplerInit(pResampler, inRate, outRate, quality, pFilter);
+
+    uint32 read = 0;
+    uint32 written = 0;
+    bool flushed = false;
+    while (written < maxFrames)
+    {
+        int n = ResamplerRead(pResampler, pOut + written, maxFrames - written);
+        written += n;
+        if (n)
+            continue;
+
+        if (read < inFrames)
+        {
+            uint32 want = ResamplerNeeded(pResampler, maxFrames - written);
+            if (want > inFrames - read)
+                want = inFrames - read;
+            ResamplerWrite(pResampler, pSample->m_Data + read, want);
+            read += want;
+        }
+        else if (!flushed)
+        {
+            ResamplerFlush(pResampler);
+            flushed = true;
+        }
+        else
+        {
+            break;
+        }
+    }
+
+    free(pResampler);
+    free(pFilter);
+
+    // The loop moves with the data it marks
+    uint32 loopStart = (uint32)((uint64)pSample->m_LoopStart * outRate / inRate);
+    uint32 loopEnd = (uint32)((uint64)pSample->m_LoopEnd * outRate / inRate);
+    if (loopEnd > written)
+        loopEnd = written;
+
+    SoundSampleRelease(pSample);
+    pSample->m_LoopStart = loopEnd > loopStart ? loopStart : 0;
+    pSample->m_LoopEnd = loopEnd > loopStart ? loopEnd : 0;
+    pSample->m_Data = pOut;
+    pSample->m_DataLen = written * sizeof(int16);
+    pSample->m_SampleRate = outRate;
+    pSample->m_Storage = SOUNDSAMPLE_STORAGE_HEAP;
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+// Self test
+//-----------------------------------------------------------------------------
+#define SELFTEST_FRAMES 1000
+
+bool ResamplerSelfTest()
+{
+    static const uint32 rates[][2] = { { 22050, 44100 }, { 44100, 48000 }, { 48000, 44100 }, { 48000, 11025 } };
+    static int16 src[SELFTEST_FRAMES];
+    static int16 out[2][SELFTEST_FRAMES * 4];
+    static Resampler r[2];
+    ResamplerFilter filter;
+    bool ok = true;
+
+    srand(4);
+    for (int i = 0; i < SELFTEST_FRAMES; i++)
+        src[i] = (int16)((rand() & 0xff) | ((rand() & 0xff) << 8));
+
+    for (int t = 0; t < (int)(sizeof(rates) / sizeof(rates[0])) && ok; t++)
+    {
+        ResamplerBuildFilter(&filter, rates[t][0], rates[t][1]);
+
+        // Vector and scalar paths fed in uneven pieces must agree exactly
+        int count[2];
+        for (int s = 0; s < 2; s++)
+        {
+            ResamplerInit(&r[s], rates[t][0], rates[t][1], RESAMPLER_SINC, &filter);
+            int read = 0;
+            count[s] = 0;
+            while (read < SELFTEST_FRAMES)
+            {
+                int want = ResamplerNeeded(&r[s], 37);
+                if (want > SELFTEST_FRAMES - read)
+                    want = SELFTEST_FRAMES - read;
+                ResamplerWrite(&r[s], src + read, want);
+                read += want;
+                count[s] += s ? ResamplerReadScalar(&r[s], out[s] + count[s], 37)
+                    : ResamplerRead(&r[s], out[s] + count[s], 37);
+            }
+        }
+        ok &= count[0] == count[1] && !memcmp(out[0], out[1], count[0] * sizeof(int16));
+
+        // Every phase passes a constant through unchanged
+        for (int p = 0; p < RESAMPLER_PHASES; p++)
+        {
+            int16 dc[RESAMPLER_TAPS];
+            for (int k = 0; k < RESAMPLER_TAPS; k++)
+                dc[k] = 10000;
+            ok &= ((Dot(dc, filter.m_Coefs[p]) + (1 << (RESAMPLER_COEF_BITS - 1))) >> RESAMPLER_COEF_BITS) == 10000;
+        }
+
+        if (!ok)
+            s3eDebugTracePrintf("resampler: self test failed at %u Hz to %u Hz", rates[t][0], rates[t][1]);
+    }
+    return ok;
+}
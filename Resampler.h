@@ -0,0 +1,154 @@
+/*
+ * This file is part of the Marmalade SDK Code Samples.
+ *
+ * Copyright (C) 2001-2011 Ideaworks3D Ltd.
+ * All Rights Reserved.
+ *
+ * This source code is intended only as a supplement to Ideaworks Labs
+ * Development Tools and/or on-line documentation.
+ *
+ * THIS CODE AND INFORMATION ARE PROVIDED "AS IS" WITHOUT WARRANTY OF ANY
+ * KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+ * PARTICULAR PURPOSE.
+ */
+// Sample rate conversion of 16 bit mono PCM
+//-----------------------------------------------------------------------------
+
+#ifndef RESAMPLER_H
+#define RESAMPLER_H
+
+#include "s3eTypes.h"
+#include "SoundSample.h"
+
+// Windowed-sinc filter length and the number of fractional positions it is
+// tabulated at
+#define RESAMPLER_TAPS          16
+#define RESAMPLER_PHASE_BITS    6
+#define RESAMPLER_PHASES        (1 << RESAMPLER_PHASE_BITS)
+
+// Source frames a resampler buffers, including the filter's history
+#define RESAMPLER_BUFFER_FRAMES 512
+
+// Largest supported ratio of source to output rate, including any change
+// of playback rate
+#define RESAMPLER_MAX_STEP      8
+
+// Playback rate at which the output is at the pitch of the source
+#define RESAMPLER_RATE_NORMAL   0x10000
+
+typedef enum ResamplerQuality
+{
+    RESAMPLER_LINEAR,           // interpolate between neighbouring frames
+    RESAMPLER_SINC,             // RESAMPLER_TAPS tap polyphase windowed-sinc
+} ResamplerQuality;
+
+/**
+ * Coefficients for one conversion ratio, in 1.14 fixed point. Each phase
+ * sums to exactly 1 << 14.
+ */
+typedef struct ResamplerFilter
+{
+    uint32  m_Cutoff;           // fraction of the source Nyquist rate, 1/256ths
+    int16   m_Coefs[RESAMPLER_PHASES][RESAMPLER_TAPS];
+} ResamplerFilter;
+
+/**
+ * Conversion state for one stream of audio. Source frames are written in
+ * and output frames read out in whatever sizes suit the caller; history is
+ * kept across calls so a stream can be fed a block, or a loop, at a time.
+ */
+typedef struct Resampler
+{
+    ResamplerQuality m_Quality;
+    const ResamplerFilter* m_pFilter;   // NULL restricts this to RESAMPLER_LINEAR
+    uint32  m_BaseStep;         // source frames per output frame at the normal rate, 16.16
+    uint32  m_Step;             // source frames per output frame, 16.16
+    uint32  m_Frac;             // position past m_Pos, 16 bit fraction
+    int     m_Pos;              // frame in m_Buf the next output is taken at
+    int     m_Have;             // frames in m_Buf
+    int16   m_Buf[RESAMPLER_BUFFER_FRAMES];
+} Resampler;
+
+/**
+ * Build the filter for converting @a inRate to @a outRate. The cutoff
+ * follows the lower of the two rates.
+ */
+void ResamplerBuildFilter(ResamplerFilter* pFilter, uint32 inRate, uint32 outRate);
+
+/**
+ * Shared filter for @a inRate to @a outRate, built the first time it is
+ * asked for. Main thread only; the filters stay valid until
+ * ResamplerTerminate().
+ * @return NULL if too many different ratios are in use.
+ */
+const ResamplerFilter* ResamplerGetFilter(uint32 inRate, uint32 outRate);
+
+/**
+ * Set up @a pResampler to convert @a inRate to @a outRate. @a pFilter must
+ * be built for the same rates; without one the quality is always linear.
+ */
+void ResamplerInit(Resampler* pResampler, uint32 inRate, uint32 outRate,
+    ResamplerQuality quality, const ResamplerFilter* pFilter);
+
+/**
+ * Change quality without losing the stream's position. Safe between any
+ * two calls on the resampler.
+ */
+void ResamplerSetQuality(Resampler* pResampler, ResamplerQuality quality);
+
+/**
+ * Play faster or slower than the source, changing pitch with it. @a rate is
+ * 16.16 fixed point; RESAMPLER_RATE_NORMAL plays at the original pitch.
+ * Takes effect from the next output frame. The filter is not rebuilt, so
+ * rates well above normal let some aliasing through. The step through the
+ * source is capped at RESAMPLER_MAX_STEP frames per output frame.
+ */
+void ResamplerSetRate(Resampler* pResampler, uint32 rate);
+
+/**
+ * Source frames needed before @a outFrames frames can be read, limited to
+ * what ResamplerWrite() can take in one call.
+ */
+int ResamplerNeeded(const Resampler* pResampler, int outFrames);
+
+/**
+ * Append @a frames source frames. @a frames must be no more than the last
+ * ResamplerNeeded() result.
+ */
+void ResamplerWrite(Resampler* pResampler, const int16* pSrc, int frames);
+
+/**
+ * Mark the end of the source, so the remaining frames can be read out.
+ */
+void ResamplerFlush(Resampler* pResampler);
+
+/**
+ * Produce up to @a frames output frames from the source written so far.
+ * @return the number of frames written to @a pDst.
+ */
+int ResamplerRead(Resampler* pResampler, int16* pDst, int frames);
+
+// Reference for ResamplerRead(): identical results without SSE2 or NEON
+int ResamplerReadScalar(Resampler* pResampler, int16* pDst, int frames);
+
+/**
+ * Convert a PCM sample in memory to @a outRate, replacing its data with a
+ * heap copy. Compressed and streamed samples are left alone.
+ * @return false if the sample could not be converted; it is unchanged.
+ */
+bool ResamplerConvertSample(SoundSample* pSample, uint32 outRate, ResamplerQuality quality);
+
+/**
+ * Check the vector paths against ResamplerReadScalar() and the filters for
+ * unity gain.
+ * @return true if every check passed.
+ */
+bool ResamplerSelfTest();
+
+/**
+ * Forget the shared filters. Only once nothing is using them.
+ */
+void ResamplerTerminate();
+
+#endif /* !RESAMPLER_H */
@@ -0,0 +1,131 @@
+/*
+ * This file is part of the Marmalade SDK Code Samples.
+ *
+ * Copyright (C) 2001-2011 Ideaworks3D Ltd.
+ * All Rights Reserved.
+ *
+ * This source code is intended only as a supplement to Ideaworks Labs
+ * Development Tools and/or on-line documentation.
+ *
+ * THIS CODE AND INFORMATION ARE PROVIDED "AS IS" WITHOUT WARRANTY OF ANY
+ * KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+ * PARTICULAR PURPOSE.
+ */
+#include "SampleCache.h"
+#include "s3eDebug.h"
+#include <malloc.h>
+#include <memory.h>
+
+typedef struct CacheSlot
+{
+    bool    m_Loaded;
+    int     m_Bytes;        // resident size once loaded, else the size hint
+    uint32  m_LastUse;      // value of g_CacheClock when last acquired
+} CacheSlot;
+
+static CacheSlot* g_CacheSlots = NULL;
+static int g_CacheNumSlots = 0;
+static uint32 g_CacheClock = 0;
+static SampleCacheLoadFn g_CacheLoad = NULL;
+static SampleCacheUnloadFn g_CacheUnload = NULL;
+static SampleCacheBusyFn g_CacheBusy = NULL;
+static SampleCacheStats g_CacheStats;
+
+void SampleCacheInit(int numSlots, int budgetBytes,
+    SampleCacheLoadFn loadFn, SampleCacheUnloadFn unloadFn, SampleCacheBusyFn busyFn)
+{
+    SampleCacheTerminate();
+
+    g_CacheSlots = (CacheSlot*)calloc(numSlots ? numSlots : 1, sizeof(CacheSlot));
+    g_CacheNumSlots = numSlots;
+    g_CacheClock = 0;
+    g_CacheLoad = loadFn;
+    g_CacheUnload = unloadFn;
+    g_CacheBusy = busyFn;
+
+    memset(&g_CacheStats, 0, sizeof(g_CacheStats));
+    g_CacheStats.m_BudgetBytes = budgetBytes;
+}
+
+void SampleCacheSetSizeHint(int slot, int bytes)
+{
+    if (slot >= 0 && slot < g_CacheNumSlots && !g_CacheSlots[slot].m_Loaded)
+        g_CacheSlots[slot].m_Bytes = bytes;
+}
+
+// Evict least recently used idle samples until @a needed more bytes fit in
+// the budget, or nothing else can be evicted
+static void MakeRoom(int needed, int keep)
+{
+    while (g_CacheStats.m_ResidentBytes + needed > g_CacheStats.m_BudgetBytes)
+    {
+        int victim = -1;
+        for (int i = 0; i < g_CacheNumSlots; i++)
+        {
+            CacheSlot* s = &g_CacheSlots[i];
+            if (!s->m_Loaded || i == keep || g_CacheBusy(i))
+                continue;
+            if (victim < 0 || s->m_LastUse < g_CacheSlots[victim].m_LastUse)
+                victim = i;
+        }
+
+        if (victim < 0)
+            break;
+
+        g_CacheUnload(victim);
+        g_CacheSlots[victim].m_Loaded = false;
+        g_CacheStats.m_ResidentBytes -= g_CacheSlots[victim].m_Bytes;
+        g_CacheStats.m_Evictions++;
+        s3eDebugTracePrintf("cache: evicted %d (%d bytes)", victim, g_CacheSlots[victim].m_Bytes);
+    }
+}
+
+bool SampleCacheAcquire(int slot)
+{
+    if (slot < 0 || slot >= g_CacheNumSlots)
+        return false;
+
+    CacheSlot* s = &g_CacheSlots[slot];
+    s->m_LastUse = ++g_CacheClock;
+
+    if (s->m_Loaded)
+    {
+        g_CacheStats.m_Hits++;
+        return true;
+    }
+
+    g_CacheStats.m_Misses++;
+    MakeRoom(s->m_Bytes, slot);
+
+    int bytes = g_CacheLoad(slot);
+    if (bytes < 0)
+        return false;
+
+    s->m_Loaded = true;
+    s->m_Bytes = bytes;
+    g_CacheStats.m_ResidentBytes += bytes;
+
+    // The hint may have been low; settle up now the real size is known
+    MakeRoom(0, slot);
+    return true;
+}
+
+void SampleCacheGetStats(SampleCacheStats* pStats)
+{
+    *pStats = g_CacheStats;
+}
+
+void SampleCacheTerminate()
+{
+    for (int i = 0; i < g_CacheNumSlots; i++)
+    {
+        if (g_CacheSlots[i].m_Loaded)
+            g_CacheUnload(i);
+    }
+
+    free(g_CacheSlots);
+    g_CacheSlots = NULL;
+    g_CacheNumSlots = 0;
+    g_CacheStats.m_ResidentBytes = 0;
+}
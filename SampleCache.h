@@ -0,0 +1,77 @@
+/*
+ * This file is part of the Marmalade SDK Code Samples.
+ *
+ * Copyright (C) 2001-2011 Ideaworks3D Ltd.
+ * All Rights Reserved.
+ *
+ * This source code is intended only as a supplement to Ideaworks Labs
+ * Development Tools and/or on-line documentation.
+ *
+ * THIS CODE AND INFORMATION ARE PROVIDED "AS IS" WITHOUT WARRANTY OF ANY
+ * KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+ * PARTICULAR PURPOSE.
+ */
+// Memory budgeted sample cache with least recently used eviction
+//-----------------------------------------------------------------------------
+
+#ifndef SAMPLE_CACHE_H
+#define SAMPLE_CACHE_H
+
+#include "s3eTypes.h"
+
+/**
+ * Load the sample in @a slot and return the bytes it now occupies, or -1
+ * on failure.
+ */
+typedef int (*SampleCacheLoadFn)(int slot);
+
+/**
+ * Release the sample in @a slot.
+ */
+typedef void (*SampleCacheUnloadFn)(int slot);
+
+/**
+ * Returns true while the sample in @a slot is sounding (playing or paused)
+ * and so must not be evicted.
+ */
+typedef bool (*SampleCacheBusyFn)(int slot);
+
+typedef struct SampleCacheStats
+{
+    uint32  m_Hits;
+    uint32  m_Misses;
+    uint32  m_Evictions;
+    int     m_ResidentBytes;
+    int     m_BudgetBytes;
+} SampleCacheStats;
+
+/**
+ * Set up a cache of @a numSlots initially unloaded samples that tries to
+ * keep at most @a budgetBytes resident.
+ */
+void SampleCacheInit(int numSlots, int budgetBytes,
+    SampleCacheLoadFn loadFn, SampleCacheUnloadFn unloadFn, SampleCacheBusyFn busyFn);
+
+/**
+ * Tell the cache how many bytes @a slot will need once loaded, so room can
+ * be made before loading rather than after. Optional.
+ */
+void SampleCacheSetSizeHint(int slot, int bytes);
+
+/**
+ * Make sure the sample in @a slot is loaded, evicting the least recently
+ * used idle samples if the budget requires it, and mark it as most
+ * recently used. Call before every trigger.
+ * @return false if the sample could not be loaded.
+ */
+bool SampleCacheAcquire(int slot);
+
+void SampleCacheGetStats(SampleCacheStats* pStats);
+
+/**
+ * Unload every cached sample and free the cache.
+ */
+void SampleCacheTerminate();
+
+#endif /* !SAMPLE_CACHE_H */
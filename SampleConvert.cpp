@@ -0,0 +1,169 @@
+/*
+ * This file is part of the Marmalade SDK Code Samples.
+ *
+ * Copyright (C) 2001-2011 Ideaworks3D Ltd.
+ * All Rights Reserved.
+ *
+ * This source code is intended only as a supplement to Ideaworks Labs
+ * Development Tools and/or on-line documentation.
+ *
+ * THIS CODE AND INFORMATION ARE PROVIDED "AS IS" WITHOUT WARRANTY OF ANY
+ * KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+ * PARTICULAR PURPOSE.
+ */
+#include "SampleConvert.h"
+#include <memory.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SAMPLECONVERT_SSE2 1
+#include <emmintrin.h>
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+#define SAMPLECONVERT_NEON 1
+#include <arm_neon.h>
+#endif
+
+// Each kernel runs a vector loop where the target has one and finishes the
+// remainder (or everything, on other targets) with the scalar loop. The
+// vector and scalar paths produce identical results.
+
+void SampleConvertU8(const uint8* pSrc, int16* pDst, int count)
+{
+    int i = 0;
+#if defined(SAMPLECONVERT_SSE2)
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i bias = _mm_set1_epi16(128);
+    for (; i + 16 <= count; i += 16)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i*)(pSrc + i));
+        __m128i lo = _mm_slli_epi16(_mm_sub_epi16(_mm_unpacklo_epi8(v, zero), bias), 8);
+        __m128i hi = _mm_slli_epi16(_mm_sub_epi16(_mm_unpackhi_epi8(v, zero), bias), 8);
+        _mm_storeu_si128((__m128i*)(pDst + i), lo);
+        _mm_storeu_si128((__m128i*)(pDst + i + 8), hi);
+    }
+#elif defined(SAMPLECONVERT_NEON)
+    const uint8x16_t bias = vdupq_n_u8(0x80);
+    for (; i + 16 <= count; i += 16)
+    {
+        int8x16_t v = vreinterpretq_s8_u8(veorq_u8(vld1q_u8(pSrc + i), bias));
+        vst1q_s16(pDst + i, vshll_n_s8(vget_low_s8(v), 8));
+        vst1q_s16(pDst + i + 8, vshll_n_s8(vget_high_s8(v), 8));
+    }
+#endif
+    for (; i < count; i++)
+        pDst[i] = (int16)((pSrc[i] - 128) << 8);
+}
+
+void SampleConvertS24(const uint8* pSrc, int16* pDst, int count)
+{
+    // Three byte samples do not map onto SSE2/NEON lanes without byte
+    // shuffles, so this one stays scalar; it only touches two bytes of three.
+    for (int i = 0; i < count; i++, pSrc += 3)
+        pDst[i] = (int16)(pSrc[1] | (pSrc[2] << 8));
+}
+
+void SampleConvertS32(const int32* pSrc, int16* pDst, int count)
+{
+    int i = 0;
+#if defined(SAMPLECONVERT_SSE2)
+    for (; i + 8 <= count; i += 8)
+    {
+        __m128i a = _mm_srai_epi32(_mm_loadu_si128((const __m128i*)(pSrc + i)), 16);
+        __m128i b = _mm_srai_epi32(_mm_loadu_si128((const __m128i*)(pSrc + i + 4)), 16);
+        _mm_storeu_si128((__m128i*)(pDst + i), _mm_packs_epi32(a, b));
+    }
+#elif defined(SAMPLECONVERT_NEON)
+    for (; i + 8 <= count; i += 8)
+    {
+        int16x4_t a = vshrn_n_s32(vld1q_s32(pSrc + i), 16);
+        int16x4_t b = vshrn_n_s32(vld1q_s32(pSrc + i + 4), 16);
+        vst1q_s16(pDst + i, vcombine_s16(a, b));
+    }
+#endif
+    for (; i < count; i++)
+        pDst[i] = (int16)(pSrc[i] >> 16);
+}
+
+void SampleConvertF32(const float* pSrc, int16* pDst, int count)
+{
+    // Clamp, scale and round half away from zero
+    int i = 0;
+#if defined(SAMPLECONVERT_SSE2)
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 minusOne = _mm_set1_ps(-1.0f);
+    const __m128 scale = _mm_set1_ps(32767.0f);
+    const __m128 half = _mm_set1_ps(0.5f);
+    const __m128 sign = _mm_set1_ps(-0.0f);
+    for (; i + 8 <= count; i += 8)
+    {
+        __m128 a = _mm_mul_ps(_mm_max_ps(_mm_min_ps(_mm_loadu_ps(pSrc + i), one), minusOne), scale);
+        __m128 b = _mm_mul_ps(_mm_max_ps(_mm_min_ps(_mm_loadu_ps(pSrc + i + 4), one), minusOne), scale);
+        a = _mm_add_ps(a, _mm_or_ps(_mm_and_ps(a, sign), half));
+        b = _mm_add_ps(b, _mm_or_ps(_mm_and_ps(b, sign), half));
+        _mm_storeu_si128((__m128i*)(pDst + i), _mm_packs_epi32(_mm_cvttps_epi32(a), _mm_cvttps_epi32(b)));
+    }
+#elif defined(SAMPLECONVERT_NEON)
+    const float32x4_t one = vdupq_n_f32(1.0f);
+    const float32x4_t minusOne = vdupq_n_f32(-1.0f);
+    const uint32x4_t sign = vdupq_n_u32(0x80000000);
+    const uint32x4_t half = vreinterpretq_u32_f32(vdupq_n_f32(0.5f));
+    for (; i + 8 <= count; i += 8)
+    {
+        float32x4_t a = vmulq_n_f32(vmaxq_f32(vminq_f32(vld1q_f32(pSrc + i), one), minusOne), 32767.0f);
+        float32x4_t b = vmulq_n_f32(vmaxq_f32(vminq_f32(vld1q_f32(pSrc + i + 4), one), minusOne), 32767.0f);
+        a = vaddq_f32(a, vreinterpretq_f32_u32(vorrq_u32(vandq_u32(vreinterpretq_u32_f32(a), sign), half)));
+        b = vaddq_f32(b, vreinterpretq_f32_u32(vorrq_u32(vandq_u32(vreinterpretq_u32_f32(b), sign), half)));
+        vst1q_s16(pDst + i, vcombine_s16(vmovn_s32(vcvtq_s32_f32(a)), vmovn_s32(vcvtq_s32_f32(b))));
+    }
+#endif
+    for (; i < count; i++)
+    {
+        float v = pSrc[i];
+        if (v > 1.0f)
+            v = 1.0f;
+        else if (v < -1.0f)
+            v = -1.0f;
+        v *= 32767.0f;
+        pDst[i] = (int16)(int32)(v < 0 ? v - 0.5f : v + 0.5f);
+    }
+}
+
+void SampleDownmix(const int16* pSrc, int16* pDst, int frames, int channels)
+{
+    if (channels == 1)
+    {
+        memcpy(pDst, pSrc, frames * sizeof(int16));
+        return;
+    }
+
+    int i = 0;
+    if (channels == 2)
+    {
+#if defined(SAMPLECONVERT_SSE2)
+        const __m128i ones = _mm_set1_epi16(1);
+        for (; i + 8 <= frames; i += 8)
+        {
+            __m128i a = _mm_madd_epi16(_mm_loadu_si128((const __m128i*)(pSrc + i*2)), ones);
+            __m128i b = _mm_madd_epi16(_mm_loadu_si128((const __m128i*)(pSrc + i*2 + 8)), ones);
+            _mm_storeu_si128((__m128i*)(pDst + i), _mm_packs_epi32(_mm_srai_epi32(a, 1), _mm_srai_epi32(b, 1)));
+        }
+#elif defined(SAMPLECONVERT_NEON)
+        for (; i + 8 <= frames; i += 8)
+        {
+            int16x8x2_t lr = vld2q_s16(pSrc + i*2);
+            vst1q_s16(pDst + i, vhaddq_s16(lr.val[0], lr.val[1]));
+        }
+#endif
+        for (; i < frames; i++)
+            pDst[i] = (int16)((pSrc[i*2] + pSrc[i*2 + 1]) >> 1);
+        return;
+    }
+
+    for (; i < frames; i++)
+    {
+        int32 sum = 0;
+        for (int c = 0; c < channels; c++)
+            sum += pSrc[i*channels + c];
+        pDst[i] = (int16)(sum / channels);
+    }
+}
@@ -0,0 +1,41 @@
+/*
+ * This file is part of the Marmalade SDK Code Samples.
+ *
+ * Copyright (C) 2001-2011 Ideaworks3D Ltd.
+ * All Rights Reserved.
+ *
+ * This source code is intended only as a supplement to Ideaworks Labs
+ * Development Tools and/or on-line documentation.
+ *
+ * THIS CODE AND INFORMATION ARE PROVIDED "AS IS" WITHOUT WARRANTY OF ANY
+ * KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+ * PARTICULAR PURPOSE.
+ */
+// PCM format conversion kernels used at load time
+//-----------------------------------------------------------------------------
+
+#ifndef SAMPLE_CONVERT_H
+#define SAMPLE_CONVERT_H
+
+#include "s3eTypes.h"
+
+// All kernels convert @a count individual samples (not frames) and assume
+// little endian source data. Source and destination must not overlap.
+
+// Unsigned 8 bit to signed 16 bit
+void SampleConvertU8(const uint8* pSrc, int16* pDst, int count);
+
+// Packed signed 24 bit to signed 16 bit (keeps the top 16 bits)
+void SampleConvertS24(const uint8* pSrc, int16* pDst, int count);
+
+// Signed 32 bit to signed 16 bit (keeps the top 16 bits)
+void SampleConvertS32(const int32* pSrc, int16* pDst, int count);
+
+// 32 bit float in [-1, 1] to signed 16 bit, clamping out of range values
+void SampleConvertF32(const float* pSrc, int16* pDst, int count);
+
+// Average interleaved @a channels channel audio down to mono
+void SampleDownmix(const int16* pSrc, int16* pDst, int frames, int channels);
+
+#endif /* !SAMPLE_CONVERT_H */
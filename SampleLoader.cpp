@@ -0,0 +1,137 @@
+/*
+ * This file is part of the Marmalade SDK Code Samples.
+ *
+ * Copyright (C) 2001-2011 Ideaworks3D Ltd.
+ * All Rights Reserved.
+ *
+ * This source code is intended only as a supplement to Ideaworks Labs
+ * Development Tools and/or on-line documentation.
+ *
+ * THIS CODE AND INFORMATION ARE PROVIDED "AS IS" WITHOUT WARRANTY OF ANY
+ * KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+ * PARTICULAR PURPOSE.
+ */
+#include "SampleLoader.h"
+#include "s3eThread.h"
+#include "s3eDebug.h"
+#include <malloc.h>
+#include <memory.h>
+
+static const char* const* g_LoaderPaths = NULL;
+static SampleLoaderFn g_LoaderFn = NULL;
+static int g_LoaderCount = 0;
+static int g_LoaderNext = 0;        // next job to hand out
+static int g_LoaderPending = 0;     // jobs not yet finished
+static SampleLoadState* g_LoaderState = NULL;
+
+// Guards everything above once the workers are running
+static s3eThreadLock* g_LoaderLock = NULL;
+static s3eThread* g_LoaderThreads[SAMPLELOADER_MAX_THREADS];
+static int g_LoaderNumThreads = 0;
+
+static void* LoaderWorker(void* userData)
+{
+    while (1)
+    {
+        s3eThreadLockAcquire(g_LoaderLock);
+        int index = g_LoaderNext < g_LoaderCount ? g_LoaderNext++ : -1;
+        s3eThreadLockRelease(g_LoaderLock);
+
+        if (index < 0)
+            break;
+
+        bool ok = g_LoaderFn(index, g_LoaderPaths[index]);
+
+        // Releasing the lock publishes everything the load function wrote
+        // before the state change becomes visible to SampleLoaderGetState
+        s3eThreadLockAcquire(g_LoaderLock);
+        g_LoaderState[index] = ok ? SAMPLELOAD_READY : SAMPLELOAD_FAILED;
+        g_LoaderPending--;
+        s3eThreadLockRelease(g_LoaderLock);
+    }
+
+    return NULL;
+}
+
+void SampleLoaderStart(const char* const* pPaths, int count, SampleLoaderFn loadFn, int numThreads)
+{
+    SampleLoaderWait();
+
+    free(g_LoaderState);
+    g_LoaderState = (SampleLoadState*)calloc(count ? count : 1, sizeof(SampleLoadState));
+    g_LoaderPaths = pPaths;
+    g_LoaderFn = loadFn;
+    g_LoaderCount = count;
+    g_LoaderNext = 0;
+    g_LoaderPending = count;
+
+    if (numThreads > count)
+        numThreads = count;
+    if (numThreads > SAMPLELOADER_MAX_THREADS)
+        numThreads = SAMPLELOADER_MAX_THREADS;
+
+    if (numThreads > 0 && s3eThreadAvailable())
+    {
+        if (!g_LoaderLock)
+            g_LoaderLock = s3eThreadLockCreate();
+
+        for (int i = 0; i < numThreads; i++)
+        {
+            g_LoaderThreads[g_LoaderNumThreads] = s3eThreadCreate(LoaderWorker, NULL, NULL);
+            if (g_LoaderThreads[g_LoaderNumThreads])
+                g_LoaderNumThreads++;
+        }
+        s3eDebugTracePrintf("loading %d samples on %d threads", count, g_LoaderNumThreads);
+    }
+
+    if (!g_LoaderNumThreads)
+    {
+        // No workers; load everything here
+        for (int i = 0; i < count; i++)
+        {
+            g_LoaderState[i] = g_LoaderFn(i, g_LoaderPaths[i]) ? SAMPLELOAD_READY : SAMPLELOAD_FAILED;
+            g_LoaderPending--;
+        }
+        g_LoaderNext = count;
+    }
+}
+
+SampleLoadState SampleLoaderGetState(int index)
+{
+    if (index < 0 || index >= g_LoaderCount)
+        return SAMPLELOAD_FAILED;
+
+    if (!g_LoaderNumThreads)
+        return g_LoaderState[index];
+
+    s3eThreadLockAcquire(g_LoaderLock);
+    SampleLoadState state = g_LoaderState[index];
+    s3eThreadLockRelease(g_LoaderLock);
+    return state;
+}
+
+int SampleLoaderNumPending()
+{
+    if (!g_LoaderNumThreads)
+        return g_LoaderPending;
+
+    s3eThreadLockAcquire(g_LoaderLock);
+    int pending = g_LoaderPending;
+    s3eThreadLockRelease(g_LoaderLock);
+    return pending;
+}
+
+void SampleLoaderWait()
+{
+    for (int i = 0; i < g_LoaderNumThreads; i++)
+        s3eThreadJoin(g_LoaderThreads[i], NULL);
+    g_LoaderNumThreads = 0;
+
+    // Without workers the state is read unlocked
+    if (g_LoaderLock)
+    {
+        s3eThreadLockDestroy(g_LoaderLock);
+        g_LoaderLock = NULL;
+    }
+}
@@ -0,0 +1,66 @@
+/*
+ * This file is part of the Marmalade SDK Code Samples.
+ *
+ * Copyright (C) 2001-2011 Ideaworks3D Ltd.
+ * All Rights Reserved.
+ *
+ * This source code is intended only as a supplement to Ideaworks Labs
+ * Development Tools and/or on-line documentation.
+ *
+ * THIS CODE AND INFORMATION ARE PROVIDED "AS IS" WITHOUT WARRANTY OF ANY
+ * KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+ * PARTICULAR PURPOSE.
+ */
+// Batch sample loading on a pool of worker threads
+//-----------------------------------------------------------------------------
+
+#ifndef SAMPLE_LOADER_H
+#define SAMPLE_LOADER_H
+
+#include "s3eTypes.h"
+
+#define SAMPLELOADER_MAX_THREADS 8
+
+typedef enum SampleLoadState
+{
+    SAMPLELOAD_PENDING = 0,
+    SAMPLELOAD_READY,
+    SAMPLELOAD_FAILED,
+} SampleLoadState;
+
+/**
+ * Loads the sample for job @a index from @a pPath. Called on a worker
+ * thread; jobs with different indices may run concurrently.
+ * @return true on success.
+ */
+typedef bool (*SampleLoaderFn)(int index, const char* pPath);
+
+/**
+ * Start loading @a count paths with @a loadFn on up to @a numThreads worker
+ * threads and return immediately. The @a pPaths strings must stay valid
+ * until loading is complete.
+ *
+ * If threads are unavailable or @a numThreads is 0 everything is loaded
+ * on the calling thread before this returns.
+ */
+void SampleLoaderStart(const char* const* pPaths, int count, SampleLoaderFn loadFn, int numThreads);
+
+/**
+ * State of job @a index. A job reported as SAMPLELOAD_READY has been fully
+ * published and its sample may be played.
+ */
+SampleLoadState SampleLoaderGetState(int index);
+
+/**
+ * Number of jobs not yet finished.
+ */
+int SampleLoaderNumPending();
+
+/**
+ * Block until every job has finished and release the worker threads and
+ * their lock. States stay readable afterwards.
+ */
+void SampleLoaderWait();
+
+#endif /* !SAMPLE_LOADER_H */
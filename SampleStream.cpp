@@ -0,0 +1,342 @@
+/*
+ * This file is part of the Marmalade SDK Code Samples.
+ *
+ * Copyright (C) 2001-2011 Ideaworks3D Ltd.
+ * All Rights Reserved.
+ *
+ * This source code is intended only as a supplement to Ideaworks Labs
+ * Development Tools and/or on-line documentation.
+ *
+ * THIS CODE AND INFORMATION ARE PROVIDED "AS IS" WITHOUT WARRANTY OF ANY
+ * KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+ * PARTICULAR PURPOSE.
+ */
+#include "SampleStream.h"
+#include "SoundAtomic.h"
+#include "s3eThread.h"
+#include "s3eDebug.h"
+#include <stdio.h>
+#include <string.h>
+#include <malloc.h>
+
+#define RING_MASK (SAMPLESTREAM_RING_FRAMES - 1)
+
+// How long the reader sleeps between refills when nothing wakes it
+#define READER_PERIOD_MS 5
+
+/*
+ * One streaming voice. The reader (the reader thread, or the main thread
+ * when threads are unavailable) fills m_Ring and advances m_Write; the
+ * mixer consumes from it and advances m_Read. Everything else is
+ * only touched with g_StreamLock held, which the audio callback never takes.
+ */
+typedef struct StreamVoice
+{
+    const SampleStreamSource* m_pSource;
+    FILE*   m_File;
+    uint32  m_Pos;              // next source frame to read
+    uint32  m_NumFrames;
+    uint32  m_LoopFrom;
+    uint32  m_LoopEnd;          // frame repeats jump back from
+    int32   m_RepeatsLeft;      // 0 repeats forever
+    bool    m_Active;
+
+    int16*  m_Ring;
+    volatile uint32 m_Write;    // frames written, free running
+    volatile uint32 m_Read;     // frames consumed, free running
+    volatile uint32 m_Eof;      // set once the last frame has been written
+} StreamVoice;
+
+static StreamVoice g_StreamVoices[SAMPLESTREAM_MAX_VOICES];
+static volatile uint32 g_StreamUnderruns = 0;
+
+static s3eThreadLock* g_StreamLock = NULL;
+static s3eThreadSem* g_StreamWake = NULL;
+static s3eThread* g_StreamThread = NULL;
+static volatile bool g_StreamQuit = false;
+
+// Scratch used while refilling; only one refill runs at a time
+static uint8* g_StreamRaw = NULL;
+static int16 g_StreamConverted[SAMPLESTREAM_READ_FRAMES];
+
+//-----------------------------------------------------------------------------
+// Sources
+//-----------------------------------------------------------------------------
+bool SampleStreamOpen(const char* pPath, const WavInfo* pInfo, SoundSample* pSample)
+{
+    SoundSampleInit(pSample);
+
+    SampleStreamSource* pSource = (SampleStreamSource*)malloc(sizeof(SampleStreamSource));
+    if (!pSource)
+        return false;
+
+    pSource->m_Path = strdup(pPath);
+    pSource->m_Info = *pInfo;
+
+    pSample->m_pStream = pSource;
+    pSample->m_DataLen = WavNativeLen(pInfo);
+    pSample->m_SampleRate = pInfo->m_SampleRate;
+    pSample->m_Storage = SOUNDSAMPLE_STORAGE_STREAM;
+    pSample->m_LoopStart = pInfo->m_LoopStart;
+    pSample->m_LoopEnd = pInfo->m_LoopEnd;
+    return true;
+}
+
+void SampleStreamSourceDestroy(SampleStreamSource* pSource)
+{
+    if (!pSource)
+        return;
+
+    free(pSource->m_Path);
+    free(pSource);
+}
+
+//-----------------------------------------------------------------------------
+// Reader
+//-----------------------------------------------------------------------------
+static void Lock()
+{
+    if (g_StreamLock)
+        s3eThreadLockAcquire(g_StreamLock);
+}
+
+static void Unlock()
+{
+    if (g_StreamLock)
+        s3eThreadLockRelease(g_StreamLock);
+}
+
+// Read ahead until the ring is full or the sample has ended. Call with the
+// lock held.
+static void Refill(StreamVoice* v)
+{
+    const WavInfo* pInfo = &v->m_pSource->m_Info;
+
+    while (v->m_Active && !v->m_Eof)
+    {
+        uint32 write = v->m_Write;
+        uint32 space = SAMPLESTREAM_RING_FRAMES - (write - SoundAtomicLoad(&v->m_Read));
+        // The last pass plays on past the loop to the end of the sample
+        uint32 end = v->m_RepeatsLeft == 1 ? v->m_NumFrames : v->m_LoopEnd;
+        uint32 n = end - v->m_Pos;
+        if (n > SAMPLESTREAM_READ_FRAMES)
+            n = SAMPLESTREAM_READ_FRAMES;
+        if (space < n)
+            break;
+
+        if (fread(g_StreamRaw, pInfo->m_BlockAlign, n, v->m_File) != n)
+        {
+            // Treat a read error like the end of the sample
+            s3eDebugTracePrintf("stream: read failed at frame %u", v->m_Pos);
+            SoundAtomicStore(&v->m_Eof, 1);
+            break;
+        }
+        WavConvertFrames(pInfo, g_StreamRaw, g_StreamConverted, n);
+
+        // Copy into the ring in up to two parts
+        uint32 start = write & RING_MASK;
+        uint32 first = SAMPLESTREAM_RING_FRAMES - start;
+        if (first > n)
+            first = n;
+        memcpy(v->m_Ring + start, g_StreamConverted, first * sizeof(int16));
+        memcpy(v->m_Ring, g_StreamConverted + first, (n - first) * sizeof(int16));
+        SoundAtomicStore(&v->m_Write, write + n);
+
+        v->m_Pos += n;
+        if (v->m_Pos == end)
+        {
+            if (v->m_RepeatsLeft == 1)
+            {
+                SoundAtomicStore(&v->m_Eof, 1);
+                break;
+            }
+            if (v->m_RepeatsLeft > 1)
+                v->m_RepeatsLeft--;
+
+            v->m_Pos = v->m_LoopFrom;
+            fseek(v->m_File, pInfo->m_DataOffset + v->m_Pos * pInfo->m_BlockAlign, SEEK_SET);
+        }
+    }
+}
+
+static void RefillAll()
+{
+    Lock();
+    for (int i = 0; i < SAMPLESTREAM_MAX_VOICES; i++)
+        Refill(&g_StreamVoices[i]);
+    Unlock();
+}
+
+static void* ReaderThread(void* userData)
+{
+    while (!g_StreamQuit)
+    {
+        RefillAll();
+        s3eThreadSemWait(g_StreamWake, READER_PERIOD_MS);
+    }
+    return NULL;
+}
+
+static bool Init()
+{
+    if (g_StreamRaw)
+        return true;
+
+    g_StreamRaw = (uint8*)malloc(SAMPLESTREAM_READ_FRAMES * WAV_MAX_CHANNELS * sizeof(int32));
+    if (!g_StreamRaw)
+        return false;
+
+    if (s3eThreadAvailable())
+    {
+        g_StreamLock = s3eThreadLockCreate();
+        g_StreamWake = s3eThreadSemCreate(0);
+        g_StreamQuit = false;
+        g_StreamThread = s3eThreadCreate(ReaderThread, NULL, NULL);
+        if (!g_StreamThread)
+        {
+            s3eThreadSemDestroy(g_StreamWake);
+            s3eThreadLockDestroy(g_StreamLock);
+            g_StreamWake = NULL;
+            g_StreamLock = NULL;
+        }
+    }
+    return true;
+}
+
+void SampleStreamUpdate()
+{
+    if (g_StreamRaw && !g_StreamThread)
+        RefillAll();
+}
+
+//-----------------------------------------------------------------------------
+// Playback
+//-----------------------------------------------------------------------------
+int SampleStreamRead(int voice, int16* pDst, int frames, bool* pEnded)
+{
+    StreamVoice* v = &g_StreamVoices[voice];
+
+    // Read m_Eof before m_Write: once it is set m_Write is final
+    uint32 eof = SoundAtomicLoad(&v->m_Eof);
+    uint32 read = v->m_Read;
+    uint32 avail = SoundAtomicLoad(&v->m_Write) - read;
+
+    uint32 n = frames;
+    if (n > avail)
+        n = avail;
+
+    // Copy out of the ring in up to two parts
+    uint32 start = read & RING_MASK;
+    uint32 first = SAMPLESTREAM_RING_FRAMES - start;
+    if (first > n)
+        first = n;
+    memcpy(pDst, v->m_Ring + start, first * sizeof(int16));
+    memcpy(pDst + first, v->m_Ring, (n - first) * sizeof(int16));
+    SoundAtomicStore(&v->m_Read, read + n);
+
+    *pEnded = eof && n == avail;
+
+    // The reader fell behind
+    if (n < (uint32)frames && !eof)
+        g_StreamUnderruns++;
+    return n;
+}
+
+s3eResult SampleStreamStart(int voice, const SoundSample* pSample, int32 repeat, int32 loopfrom, int32 loopend)
+{
+    if (voice < 0 || voice >= SAMPLESTREAM_MAX_VOICES || !pSample->m_pStream || !Init())
+        return S3E_RESULT_ERROR;
+
+    const SampleStreamSource* pSource = pSample->m_pStream;
+    const WavInfo* pInfo = &pSource->m_Info;
+    StreamVoice* v = &g_StreamVoices[voice];
+
+    if (!v->m_Ring)
+    {
+        v->m_Ring = (int16*)malloc(SAMPLESTREAM_RING_FRAMES * sizeof(int16));
+        if (!v->m_Ring)
+            return S3E_RESULT_ERROR;
+    }
+
+    FILE* f = fopen(pSource->m_Path, "rb");
+    if (!f)
+        return S3E_RESULT_ERROR;
+
+    uint32 numFrames = WavNumFrames(pInfo);
+    if (loopend <= 0 || (uint32)loopend > numFrames)
+        loopend = numFrames;
+    if (loopfrom < 0 || loopfrom >= loopend)
+        loopfrom = 0;
+
+    Lock();
+    if (v->m_File)
+        fclose(v->m_File);
+    v->m_pSource = pSource;
+    v->m_File = f;
+    v->m_Pos = 0;
+    v->m_NumFrames = numFrames;
+    v->m_LoopFrom = loopfrom;
+    v->m_LoopEnd = loopend;
+    v->m_RepeatsLeft = repeat;
+    v->m_Write = 0;
+    v->m_Read = 0;
+    v->m_Eof = 0;
+    v->m_Active = true;
+    fseek(f, pInfo->m_DataOffset, SEEK_SET);
+
+    // Prime the ring so playback can start immediately
+    Refill(v);
+    Unlock();
+    return S3E_RESULT_SUCCESS;
+}
+
+void SampleStreamStop(int voice)
+{
+    if (voice < 0 || voice >= SAMPLESTREAM_MAX_VOICES)
+        return;
+
+    StreamVoice* v = &g_StreamVoices[voice];
+    if (!v->m_Active)
+        return;
+
+    Lock();
+    if (v->m_File)
+        fclose(v->m_File);
+    v->m_File = NULL;
+    v->m_pSource = NULL;
+    v->m_Active = false;
+    Unlock();
+}
+
+uint32 SampleStreamGetUnderruns()
+{
+    return g_StreamUnderruns;
+}
+
+void SampleStreamTerminate()
+{
+    for (int i = 0; i < SAMPLESTREAM_MAX_VOICES; i++)
+        SampleStreamStop(i);
+
+    if (g_StreamThread)
+    {
+        g_StreamQuit = true;
+        s3eThreadSemPost(g_StreamWake);
+        s3eThreadJoin(g_StreamThread, NULL);
+        s3eThreadSemDestroy(g_StreamWake);
+        s3eThreadLockDestroy(g_StreamLock);
+        g_StreamThread = NULL;
+        g_StreamWake = NULL;
+        g_StreamLock = NULL;
+    }
+
+    for (int i = 0; i < SAMPLESTREAM_MAX_VOICES; i++)
+    {
+        free(g_StreamVoices[i].m_Ring);
+        g_StreamVoices[i].m_Ring = NULL;
+    }
+
+    free(g_StreamRaw);
+    g_StreamRaw = NULL;
+}
@@ -0,0 +1,96 @@
+/*
+ * This file is part of the Marmalade SDK Code Samples.
+ *
+ * Copyright (C) 2001-2011 Ideaworks3D Ltd.
+ * All Rights Reserved.
+ *
+ * This source code is intended only as a supplement to Ideaworks Labs
+ * Development Tools and/or on-line documentation.
+ *
+ * THIS CODE AND INFORMATION ARE PROVIDED "AS IS" WITHOUT WARRANTY OF ANY
+ * KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+ * PARTICULAR PURPOSE.
+ */
+// Playback of long samples streamed from disk
+//-----------------------------------------------------------------------------
+
+#ifndef SAMPLE_STREAM_H
+#define SAMPLE_STREAM_H
+
+#include "s3eTypes.h"
+#include "SoundSample.h"
+#include "WavFile.h"
+
+// One stream voice per mixer voice
+#define SAMPLESTREAM_MAX_VOICES     32
+
+// Frames buffered ahead of the play cursor for each stream voice.
+// Must be a power of two.
+#define SAMPLESTREAM_RING_FRAMES    0x4000
+
+// Frames read from disk per refill
+#define SAMPLESTREAM_READ_FRAMES    0x800
+
+/**
+ * What a streamed sample keeps resident: where its data lives on disk.
+ */
+typedef struct SampleStreamSource
+{
+    char*   m_Path;
+    WavInfo m_Info;
+} SampleStreamSource;
+
+/**
+ * Turn @a pSample into a streamed sample for @a pPath, whose header has
+ * already been parsed into @a pInfo. No sample data is read.
+ */
+bool SampleStreamOpen(const char* pPath, const WavInfo* pInfo, SoundSample* pSample);
+
+/**
+ * Free a source created by SampleStreamOpen. Called by SoundSampleRelease.
+ */
+void SampleStreamSourceDestroy(SampleStreamSource* pSource);
+
+/**
+ * Start streaming @a pSample into stream voice @a voice, which must not be
+ * being read. @a repeat and @a loopfrom behave as for s3eSoundChannelPlay:
+ * @a repeat 0 loops forever and every repeat after the first starts from
+ * frame @a loopfrom. Every pass but the last stops short at @a loopend, or
+ * at the end of the sample if @a loopend is 0. Loops are handled by the
+ * reader, so SampleStreamRead sees one continuous stream.
+ */
+s3eResult SampleStreamStart(int voice, const SoundSample* pSample, int32 repeat, int32 loopfrom, int32 loopend);
+
+/**
+ * Copy up to @a frames buffered frames of @a voice to @a pDst. Called from
+ * the audio callback; never blocks. @a pEnded is set once the last frame of
+ * the stream has been read.
+ * @return frames copied. Fewer than @a frames without @a pEnded set is an
+ * underrun.
+ */
+int SampleStreamRead(int voice, int16* pDst, int frames, bool* pEnded);
+
+/**
+ * Stop streaming into @a voice and close its file. The voice must no
+ * longer be being read.
+ */
+void SampleStreamStop(int voice);
+
+/**
+ * Refill stream voices from the calling thread. Only needed once per
+ * frame when threads are unavailable; otherwise a reader thread does this.
+ */
+void SampleStreamUpdate();
+
+/**
+ * Number of times a stream voice ran out of buffered data.
+ */
+uint32 SampleStreamGetUnderruns();
+
+/**
+ * Stop the reader thread and free all stream buffers.
+ */
+void SampleStreamTerminate();
+
+#endif /* !SAMPLE_STREAM_H */
@@ -0,0 +1,52 @@
+/*
+ * This file is part of the Marmalade SDK Code Samples.
+ *
+ * Copyright (C) 2001-2011 Ideaworks3D Ltd.
+ * All Rights Reserved.
+ *
+ * This source code is intended only as a supplement to Ideaworks Labs
+ * Development Tools and/or on-line documentation.
+ *
+ * THIS CODE AND INFORMATION ARE PROVIDED "AS IS" WITHOUT WARRANTY OF ANY
+ * KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+ * PARTICULAR PURPOSE.
+ */
+// Memory ordering helpers for data shared with the audio callback
+//-----------------------------------------------------------------------------
+
+#ifndef SOUND_ATOMIC_H
+#define SOUND_ATOMIC_H
+
+#include "s3eTypes.h"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+// x86 only reorders stores after loads, which single producer/single
+// consumer hand-offs never depend on; stopping the compiler is enough
+#define SoundMemoryBarrier() _ReadWriteBarrier()
+#else
+#define SoundMemoryBarrier() __sync_synchronize()
+#endif
+
+/**
+ * Read a value written by another thread. Loads issued after this call
+ * observe everything the writer did before its SoundAtomicStore.
+ */
+inline uint32 SoundAtomicLoad(const volatile uint32* p)
+{
+    uint32 v = *p;
+    SoundMemoryBarrier();
+    return v;
+}
+
+/**
+ * Publish a value to another thread after everything written before it.
+ */
+inline void SoundAtomicStore(volatile uint32* p, uint32 v)
+{
+    SoundMemoryBarrier();
+    *p = v;
+}
+
+#endif /* !SOUND_ATOMIC_H */
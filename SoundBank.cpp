@@ -0,0 +1,217 @@
+/*
+ * This file is part of the Marmalade SDK Code Samples.
+ *
+ * Copyright (C) 2001-2011 Ideaworks3D Ltd.
+ * All Rights Reserved.
+ *
+ * This source code is intended only as a supplement to Ideaworks Labs
+ * Development Tools and/or on-line documentation.
+ *
+ * THIS CODE AND INFORMATION ARE PROVIDED "AS IS" WITHOUT WARRANTY OF ANY
+ * KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+ * PARTICULAR PURPOSE.
+ */
+#include "SoundBank.h"
+#include "Adpcm.h"
+#include "s3eDebug.h"
+#include <stdio.h>
+#include <string.h>
+#include <malloc.h>
+
+struct SoundBank
+{
+    const uint8*            m_pBase;
+    int                     m_Len;
+    bool                    m_Mapped;
+    const SoundBankHeader*  m_pHeader;
+    const SoundBankEntry*   m_pEntries;
+    const char*             m_pNames;
+};
+
+static uint8* ReadWhole(const char* pPath, int* pLen)
+{
+    FILE* f = fopen(pPath, "rb");
+    if (!f)
+        return NULL;
+
+    fseek(f, 0, SEEK_END);
+    int len = ftell(f);
+    fseek(f, 0, SEEK_SET);
+
+    uint8* p = len > 0 ? (uint8*)malloc(len) : NULL;
+    if (p && fread(p, 1, len, f) != (size_t)len)
+    {
+        free(p);
+        p = NULL;
+    }
+    fclose(f);
+
+    *pLen = len;
+    return p;
+}
+
+// The same limits WavParse() puts on IMA-ADPCM, so a bad entry can never
+// decode past the end of a voice's block buffer
+static bool ValidAdpcm(const SoundBankEntry* e)
+{
+    int channels = e->m_NumChannels;
+    int align = e->m_BlockAlign;
+    if (channels < 1 || channels > ADPCM_MAX_CHANNELS ||
+        align <= 4 * channels || (align - 4 * channels) % (4 * channels))
+        return false;
+
+    if (e->m_FramesPerBlock != (uint32)AdpcmBlockFrames(align, channels) ||
+        e->m_FramesPerBlock > ADPCM_MAX_BLOCK_FRAMES)
+        return false;
+
+    // Counted as WavNumFrames() does. Loop points are checked against
+    // m_NumFrames, so it must not promise frames the data does not hold.
+    uint32 frames = e->m_DataLen / align * e->m_FramesPerBlock + AdpcmBlockFrames(e->m_DataLen % align, channels);
+    return e->m_NumFrames <= frames;
+}
+
+static bool Validate(const SoundBank* pBank)
+{
+    const SoundBankHeader* h = pBank->m_pHeader;
+    uint32 len = pBank->m_Len;
+
+    if (len < sizeof(SoundBankHeader) || memcmp(h->m_Magic, SOUNDBANK_MAGIC, 4) ||
+        h->m_Version != SOUNDBANK_VERSION || h->m_FileLen != len)
+        return false;
+
+    if (h->m_EntriesOffset > len || h->m_NumSamples > (len - h->m_EntriesOffset) / sizeof(SoundBankEntry))
+        return false;
+
+    if (h->m_NamesOffset > len || h->m_NamesLen > len - h->m_NamesOffset ||
+        !h->m_NamesLen || pBank->m_pNames[h->m_NamesLen - 1] != '\0')
+        return false;
+
+    for (uint32 i = 0; i < h->m_NumSamples; i++)
+    {
+        const SoundBankEntry* e = &pBank->m_pEntries[i];
+        if (e->m_NameOffset >= h->m_NamesLen ||
+            e->m_DataOffset > len || e->m_DataLen > len - e->m_DataOffset ||
+            e->m_DataOffset % SOUNDBANK_ALIGN || !e->m_SampleRate)
+            return false;
+
+        if (e->m_Codec == SOUNDSAMPLE_CODEC_PCM ? e->m_DataLen != e->m_NumFrames * sizeof(int16)
+            : e->m_Codec != SOUNDSAMPLE_CODEC_IMA_ADPCM || !ValidAdpcm(e))
+            return false;
+    }
+    return true;
+}
+
+SoundBank* SoundBankOpen(const char* pPath)
+{
+    SoundBank* pBank = (SoundBank*)calloc(1, sizeof(SoundBank));
+    if (!pBank)
+        return NULL;
+
+    pBank->m_pBase = (const uint8*)SoundSampleMapFile(pPath, &pBank->m_Len);
+    pBank->m_Mapped = pBank->m_pBase != NULL;
+    if (!pBank->m_pBase)
+        pBank->m_pBase = ReadWhole(pPath, &pBank->m_Len);
+
+    if (!pBank->m_pBase)
+    {
+        free(pBank);
+        return NULL;
+    }
+
+    pBank->m_pHeader = (const SoundBankHeader*)pBank->m_pBase;
+    pBank->m_pEntries = (const SoundBankEntry*)(pBank->m_pBase + pBank->m_pHeader->m_EntriesOffset);
+    pBank->m_pNames = (const char*)pBank->m_pBase + pBank->m_pHeader->m_NamesOffset;
+
+    if (!Validate(pBank))
+    {
+        s3eDebugTracePrintf("bank: %s is not a valid sound bank", pPath);
+        SoundBankClose(pBank);
+        return NULL;
+    }
+
+    s3eDebugTracePrintf("bank: opened %s, %d samples", pPath, pBank->m_pHeader->m_NumSamples);
+    return pBank;
+}
+
+void SoundBankClose(SoundBank* pBank)
+{
+    if (!pBank)
+        return;
+
+    if (pBank->m_Mapped)
+        SoundSampleUnmapFile((void*)pBank->m_pBase, pBank->m_Len);
+    else
+        free((void*)pBank->m_pBase);
+    free(pBank);
+}
+
+int SoundBankGetCount(const SoundBank* pBank)
+{
+    return pBank->m_pHeader->m_NumSamples;
+}
+
+const char* SoundBankGetName(const SoundBank* pBank, int index)
+{
+    return pBank->m_pNames + pBank->m_pEntries[index].m_NameOffset;
+}
+
+int SoundBankFind(const SoundBank* pBank, const char* pName)
+{
+    // Entries are sorted by name, case insensitively
+    int lo = 0;
+    int hi = SoundBankGetCount(pBank) - 1;
+    while (lo <= hi)
+    {
+        int mid = (lo + hi) / 2;
+        int cmp = stricmp(pName, SoundBankGetName(pBank, mid));
+        if (!cmp)
+            return mid;
+        if (cmp < 0)
+            hi = mid - 1;
+        else
+            lo = mid + 1;
+    }
+    return -1;
+}
+
+const SoundBankEntry* SoundBankGetEntry(const SoundBank* pBank, int index)
+{
+    return &pBank->m_pEntries[index];
+}
+
+bool SoundBankGetSample(const SoundBank* pBank, int index, SoundSample* pSample)
+{
+    SoundSampleInit(pSample);
+    if (index < 0 || index >= SoundBankGetCount(pBank))
+        return false;
+
+    const SoundBankEntry* e = &pBank->m_pEntries[index];
+    const uint8* pData = pBank->m_pBase + e->m_DataOffset;
+
+    pSample->m_Storage = SOUNDSAMPLE_STORAGE_BANK;
+    pSample->m_SampleRate = e->m_SampleRate;
+    pSample->m_DataLen = e->m_NumFrames * sizeof(int16);
+    pSample->m_Codec = (SoundSampleCodec)e->m_Codec;
+
+    // Loops from older banks, or that do not fit the sample, are ignored
+    if (e->m_LoopStart >= 0 && e->m_LoopEnd > e->m_LoopStart && (uint32)e->m_LoopEnd <= e->m_NumFrames)
+    {
+        pSample->m_LoopStart = e->m_LoopStart;
+        pSample->m_LoopEnd = e->m_LoopEnd;
+    }
+
+    if (pSample->m_Codec == SOUNDSAMPLE_CODEC_PCM)
+    {
+        pSample->m_Data = (int16*)pData;
+    }
+    else
+    {
+        pSample->m_pEncoded = pData;
+        pSample->m_EncodedLen = e->m_DataLen;
+        pSample->m_BlockAlign = e->m_BlockAlign;
+        pSample->m_NumChannels = e->m_NumChannels;
+        pSample->m_FramesPerBlock = e->m_FramesPerBlock;
+    }
+    return true;
+}
@@ -0,0 +1,98 @@
+/*
+ * This file is part of the Marmalade SDK Code Samples.
+ *
+ * Copyright (C) 2001-2011 Ideaworks3D Ltd.
+ * All Rights Reserved.
+ *
+ * This source code is intended only as a supplement to Ideaworks Labs
+ * Development Tools and/or on-line documentation.
+ *
+ * THIS CODE AND INFORMATION ARE PROVIDED "AS IS" WITHOUT WARRANTY OF ANY
+ * KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+ * PARTICULAR PURPOSE.
+ */
+// Prebuilt sound banks: many samples in one file
+//-----------------------------------------------------------------------------
+
+#ifndef SOUND_BANK_H
+#define SOUND_BANK_H
+
+#include "s3eTypes.h"
+#include "SoundSample.h"
+
+/*
+ * Bank file layout (all values little endian):
+ *
+ *   SoundBankHeader
+ *   SoundBankEntry[m_NumSamples]   sorted by name
+ *   name table                     NUL terminated names
+ *   sample data                    each sample starts on a SOUNDBANK_ALIGN boundary
+ *
+ * Sample data is stored in the engine's format (16 bit mono PCM), or as
+ * IMA-ADPCM blocks for samples that were compressed, so nothing is
+ * converted at load time. Banks are built by SoundBankPacker.
+ */
+#define SOUNDBANK_MAGIC     "SBNK"
+#define SOUNDBANK_VERSION   1
+#define SOUNDBANK_ALIGN     16
+
+typedef struct SoundBankHeader
+{
+    char    m_Magic[4];
+    uint32  m_Version;
+    uint32  m_NumSamples;
+    uint32  m_EntriesOffset;
+    uint32  m_NamesOffset;
+    uint32  m_NamesLen;
+    uint32  m_FileLen;
+} SoundBankHeader;
+
+typedef struct SoundBankEntry
+{
+    uint32  m_NameOffset;       // into the name table
+    uint32  m_DataOffset;       // from the start of the file
+    uint32  m_DataLen;          // bytes
+    uint32  m_NumFrames;
+    uint32  m_SampleRate;
+    uint16  m_Codec;            // SoundSampleCodec
+    uint16  m_NumChannels;      // channels in the encoded data
+    uint16  m_BlockAlign;       // bytes per encoded block
+    uint16  m_Reserved;
+    uint32  m_FramesPerBlock;
+    int32   m_LoopStart;        // first frame of the loop, -1 if none
+    int32   m_LoopEnd;          // frame after the last frame of the loop
+} SoundBankEntry;
+
+typedef struct SoundBank SoundBank;
+
+/**
+ * Open a bank file with a single mapping (or a single read where mapping
+ * is unavailable) and validate its tables.
+ * @return the bank, or NULL on failure.
+ */
+SoundBank* SoundBankOpen(const char* pPath);
+
+/**
+ * Close a bank. Samples obtained from it become invalid.
+ */
+void SoundBankClose(SoundBank* pBank);
+
+int SoundBankGetCount(const SoundBank* pBank);
+
+const char* SoundBankGetName(const SoundBank* pBank, int index);
+
+/**
+ * Index of the sample called @a pName (case insensitive), or -1.
+ */
+int SoundBankFind(const SoundBank* pBank, const char* pName);
+
+const SoundBankEntry* SoundBankGetEntry(const SoundBank* pBank, int index);
+
+/**
+ * Fill in @a pSample to refer to sample @a index in place. The sample does
+ * not own its data; SoundSampleRelease() on it only resets the handle.
+ */
+bool SoundBankGetSample(const SoundBank* pBank, int index, SoundSample* pSample);
+
+#endif /* !SOUND_BANK_H */
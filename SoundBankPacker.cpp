@@ -0,0 +1,185 @@
+/*
+ * This file is part of the Marmalade SDK Code Samples.
+ *
+ * Copyright (C) 2001-2011 Ideaworks3D Ltd.
+ * All Rights Reserved.
+ *
+ * This source code is intended only as a supplement to Ideaworks Labs
+ * Development Tools and/or on-line documentation.
+ *
+ * THIS CODE AND INFORMATION ARE PROVIDED "AS IS" WITHOUT WARRANTY OF ANY
+ * KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+ * PARTICULAR PURPOSE.
+ */
+
+/*
+ * Host-side tool that packs every .wav file in a directory into a single
+ * sound bank (see SoundBank.h). Run it in the simulator from the data
+ * folder:
+ *
+ *   [SoundBankPacker]
+ *   Input  = .               directory to scan
+ *   Output = sounds.bank     bank file to write
+ */
+#include "s3e.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <dirent.h>
+#include <malloc.h>
+#include <memory.h>
+
+#include "SoundBank.h"
+#include "WavFile.h"
+
+#define MAX_BANK_SAMPLES 1024
+
+typedef struct PackItem
+{
+    char*       m_Name;         // file name without .wav
+    char*       m_Path;
+    SoundSample m_Sample;
+} PackItem;
+
+static PackItem g_Items[MAX_BANK_SAMPLES];
+
+static int CompareItems(const void* a, const void* b)
+{
+    return stricmp(((const PackItem*)a)->m_Name, ((const PackItem*)b)->m_Name);
+}
+
+static uint32 Align(uint32 offset)
+{
+    return (offset + SOUNDBANK_ALIGN - 1) & ~(SOUNDBANK_ALIGN - 1);
+}
+
+static void Pad(FILE* f, uint32 from, uint32 to)
+{
+    static const uint8 zeros[SOUNDBANK_ALIGN] = { 0 };
+    fwrite(zeros, 1, to - from, f);
+}
+
+static bool Pack(const char* pInput, const char* pOutput)
+{
+    DIR* d = opendir(pInput);
+    if (!d)
+    {
+        s3eDebugTracePrintf("packer: can't open %s", pInput);
+        return false;
+    }
+
+    // Gather and load the samples
+    int count = 0;
+    uint32 namesLen = 0;
+    struct dirent* ent;
+    while ((ent = readdir(d)) && count < MAX_BANK_SAMPLES)
+    {
+        int len = strlen(ent->d_name);
+        if (len < 4 || stricmp(ent->d_name+len-4, ".wav"))
+            continue;
+
+        PackItem* pItem = &g_Items[count];
+        pItem->m_Path = (char*)malloc(strlen(pInput) + len + 2);
+        sprintf(pItem->m_Path, "%s/%s", pInput, ent->d_name);
+
+        if (!WavLoad(pItem->m_Path, &pItem->m_Sample, WAV_LOAD_COPY))
+        {
+            s3eDebugTracePrintf("packer: skipping %s", pItem->m_Path);
+            free(pItem->m_Path);
+            continue;
+        }
+
+        ent->d_name[len-4] = '\0';
+        pItem->m_Name = strdup(ent->d_name);
+        namesLen += len - 3;
+        count++;
+    }
+    closedir(d);
+
+    // Sorted so SoundBankFind can binary search
+    qsort(g_Items, count, sizeof(PackItem), CompareItems);
+
+    SoundBankHeader header;
+    memcpy(header.m_Magic, SOUNDBANK_MAGIC, 4);
+    header.m_Version = SOUNDBANK_VERSION;
+    header.m_NumSamples = count;
+    header.m_EntriesOffset = sizeof(SoundBankHeader);
+    header.m_NamesOffset = header.m_EntriesOffset + count * sizeof(SoundBankEntry);
+    header.m_NamesLen = namesLen ? namesLen : 1;
+
+    SoundBankEntry* pEntries = (SoundBankEntry*)calloc(count ? count : 1, sizeof(SoundBankEntry));
+    uint32 nameOffset = 0;
+    uint32 offset = Align(header.m_NamesOffset + header.m_NamesLen);
+    for (int i = 0; i < count; i++)
+    {
+        const SoundSample* s = &g_Items[i].m_Sample;
+        SoundBankEntry* e = &pEntries[i];
+
+        e->m_NameOffset = nameOffset;
+        nameOffset += strlen(g_Items[i].m_Name) + 1;
+
+        e->m_DataOffset = offset;
+        e->m_DataLen = s->m_Codec == SOUNDSAMPLE_CODEC_PCM ? s->m_DataLen : s->m_EncodedLen;
+        e->m_NumFrames = s->m_DataLen / sizeof(int16);
+        e->m_SampleRate = s->m_SampleRate;
+        e->m_Codec = (uint16)s->m_Codec;
+        e->m_NumChannels = s->m_Codec == SOUNDSAMPLE_CODEC_PCM ? 1 : s->m_NumChannels;
+        e->m_BlockAlign = s->m_BlockAlign;
+        e->m_FramesPerBlock = s->m_FramesPerBlock;
+        e->m_LoopStart = s->m_LoopEnd ? (int32)s->m_LoopStart : -1;
+        e->m_LoopEnd = s->m_LoopEnd ? (int32)s->m_LoopEnd : -1;
+
+        offset = Align(offset + e->m_DataLen);
+    }
+    header.m_FileLen = offset;
+
+    FILE* f = fopen(pOutput, "wb");
+    if (!f)
+    {
+        s3eDebugTracePrintf("packer: can't write %s", pOutput);
+        free(pEntries);
+        return false;
+    }
+
+    fwrite(&header, sizeof(header), 1, f);
+    fwrite(pEntries, sizeof(SoundBankEntry), count, f);
+    for (int i = 0; i < count; i++)
+        fwrite(g_Items[i].m_Name, 1, strlen(g_Items[i].m_Name) + 1, f);
+    if (!namesLen)
+        fputc(0, f);
+
+    uint32 pos = header.m_NamesOffset + header.m_NamesLen;
+    for (int i = 0; i < count; i++)
+    {
+        const SoundSample* s = &g_Items[i].m_Sample;
+        Pad(f, pos, pEntries[i].m_DataOffset);
+        fwrite(s->m_Codec == SOUNDSAMPLE_CODEC_PCM ? (const void*)s->m_Data : (const void*)s->m_pEncoded,
+            1, pEntries[i].m_DataLen, f);
+        pos = pEntries[i].m_DataOffset + pEntries[i].m_DataLen;
+
+        s3eDebugTracePrintf("packer: %-32s %8u bytes %6u Hz", g_Items[i].m_Name, pEntries[i].m_DataLen, pEntries[i].m_SampleRate);
+    }
+    Pad(f, pos, header.m_FileLen);
+    fclose(f);
+
+    s3eDebugTracePrintf("packer: wrote %d samples, %u bytes to %s", count, header.m_FileLen, pOutput);
+
+    for (int i = 0; i < count; i++)
+    {
+        SoundSampleRelease(&g_Items[i].m_Sample);
+        free(g_Items[i].m_Name);
+        free(g_Items[i].m_Path);
+    }
+    free(pEntries);
+    return true;
+}
+
+int main()
+{
+    char input[S3E_CONFIG_STRING_MAX] = ".";
+    char output[S3E_CONFIG_STRING_MAX] = "sounds.bank";
+    s3eConfigGetString("SoundBankPacker", "Input", input);
+    s3eConfigGetString("SoundBankPacker", "Output", output);
+
+    return Pack(input, output) ? 0 : 1;
+}
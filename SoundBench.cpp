@@ -0,0 +1,369 @@
+/*
+ * This file is part of the Marmalade SDK Code Samples.
+ *
+ * Copyright (C) 2001-2011 Ideaworks3D Ltd.
+ * All Rights Reserved.
+ *
+ * This source code is intended only as a supplement to Ideaworks Labs
+ * Development Tools and/or on-line documentation.
+ *
+ * THIS CODE AND INFORMATION ARE PROVIDED "AS IS" WITHOUT WARRANTY OF ANY
+ * KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+ * PARTICULAR PURPOSE.
+ */
+#include "SoundBench.h"
+#include "Adpcm.h"
+#include "MixKernels.h"
+#include "Resampler.h"
+#include "MasterEffects.h"
+#include "s3eSoundPool.h"
+#include "s3eTimer.h"
+#include "s3eConfig.h"
+#include "s3eDebug.h"
+#include <malloc.h>
+#include <memory.h>
+#include <stdlib.h>
+
+// Each benchmark repeats its work for at least this long
+#define BENCH_MS            200
+
+// Frames per block for a 256 byte mono IMA-ADPCM block
+#define BENCH_ADPCM_ALIGN   256
+#define BENCH_ADPCM_BLOCKS  64
+
+// Reference rate used to express costs as a share of real time
+#define BENCH_RATE          44100
+
+// Clock speed of the device, from [SoundBoard] BenchMHz, so costs can also
+// be given in cycles. There is no portable way to read it.
+static int g_BenchMHz = 0;
+
+static void Report(const char* pName, int64 frames, int64 ms)
+{
+    if (ms <= 0)
+        ms = 1;
+    // Picoseconds per frame, and the share of one core a single 44.1kHz
+    // voice takes in hundredths of a percent
+    int64 psPerFrame = ms * 1000000000 / frames;
+    int64 load = psPerFrame * BENCH_RATE / 100000000;
+    if (g_BenchMHz)
+    {
+        int64 centiCycles = psPerFrame * g_BenchMHz / 10000;
+        s3eDebugTracePrintf("bench %-24s %6d.%03d ns/frame  %3d.%02d%% of a core per voice  %4d.%02d cycles/frame",
+            pName, (int)(psPerFrame / 1000), (int)(psPerFrame % 1000), (int)(load / 100), (int)(load % 100),
+            (int)(centiCycles / 100), (int)(centiCycles % 100));
+        return;
+    }
+    s3eDebugTracePrintf("bench %-24s %6d.%03d ns/frame  %3d.%02d%% of a core per voice",
+        pName, (int)(psPerFrame / 1000), (int)(psPerFrame % 1000), (int)(load / 100), (int)(load % 100));
+}
+
+static void BenchAdpcm()
+{
+    // Any byte stream is valid IMA-ADPCM once the block headers are sane
+    uint8* pEncoded = (uint8*)malloc(BENCH_ADPCM_ALIGN * BENCH_ADPCM_BLOCKS);
+    int framesPerBlock = AdpcmBlockFrames(BENCH_ADPCM_ALIGN, 1);
+    int16* pDecoded = (int16*)malloc(framesPerBlock * BENCH_ADPCM_BLOCKS * sizeof(int16));
+    int16* pOut = (int16*)malloc(framesPerBlock * sizeof(int16));
+    if (!pEncoded || !pDecoded || !pOut)
+    {
+        free(pEncoded);
+        free(pDecoded);
+        free(pOut);
+        return;
+    }
+
+    srand(1);
+    for (int i = 0; i < BENCH_ADPCM_ALIGN * BENCH_ADPCM_BLOCKS; i++)
+        pEncoded[i] = (uint8)rand();
+    for (int b = 0; b < BENCH_ADPCM_BLOCKS; b++)
+        pEncoded[b * BENCH_ADPCM_ALIGN + 2] = 40;   // step index
+
+    // Decode a block at a time, as the channel callback does
+    int64 frames = 0;
+    int64 start = s3eTimerGetMs();
+    int64 elapsed;
+    do
+    {
+        for (int b = 0; b < BENCH_ADPCM_BLOCKS; b++)
+            frames += AdpcmDecodeBlock(pEncoded + b * BENCH_ADPCM_ALIGN, BENCH_ADPCM_ALIGN, 1, pOut);
+        elapsed = s3eTimerGetMs() - start;
+    } while (elapsed < BENCH_MS);
+    Report("ima-adpcm decode", frames, elapsed);
+
+    // The raw PCM path only copies already decoded frames to the target
+    for (int b = 0; b < BENCH_ADPCM_BLOCKS; b++)
+        AdpcmDecodeBlock(pEncoded + b * BENCH_ADPCM_ALIGN, BENCH_ADPCM_ALIGN, 1, pDecoded + b * framesPerBlock);
+
+    frames = 0;
+    start = s3eTimerGetMs();
+    do
+    {
+        for (int b = 0; b < BENCH_ADPCM_BLOCKS; b++)
+            memcpy(pOut, pDecoded + b * framesPerBlock, framesPerBlock * sizeof(int16));
+        frames += framesPerBlock * BENCH_ADPCM_BLOCKS;
+        elapsed = s3eTimerGetMs() - start;
+    } while (elapsed < BENCH_MS);
+    Report("pcm copy", frames, elapsed);
+
+    s3eDebugTracePrintf("bench resident bytes per second of audio: adpcm %d, pcm %d",
+        BENCH_RATE * BENCH_ADPCM_ALIGN / framesPerBlock, BENCH_RATE * (int)sizeof(int16));
+
+    free(pEncoded);
+    free(pDecoded);
+    free(pOut);
+}
+
+// Frames per call of the mix kernels, as in the mixer
+#define BENCH_MIX_FRAMES    256
+
+typedef void (*MixMonoFn)(const int16* pSrc, int32* pAccum, int frames, int32 gain);
+typedef void (*MixRampFn)(const int16* pSrc, int32* pAccum, int frames, int32 gain16, int32 step16);
+typedef void (*MixStereoFn)(const int16* pSrc, int32* pAccum, int frames, int32 gainL, int32 gainR);
+typedef void (*MixStereoRampFn)(const int16* pSrc, int32* pAccum, int frames,
+    int32 gainL16, int32 stepL16, int32 gainR16, int32 stepR16);
+typedef void (*MixClipFn)(const int32* pAccum, int16* pDst, int count, bool add);
+
+static void BenchMixMono(const char* pName, MixMonoFn fn, const int16* pSrc, int32* pAccum)
+{
+    int64 frames = 0;
+    int64 start = s3eTimerGetMs();
+    int64 elapsed;
+    do
+    {
+        for (int i = 0; i < 64; i++)
+            fn(pSrc, pAccum, BENCH_MIX_FRAMES, 0xb5);
+        frames += 64 * BENCH_MIX_FRAMES;
+        elapsed = s3eTimerGetMs() - start;
+    } while (elapsed < BENCH_MS);
+    Report(pName, frames, elapsed);
+}
+
+static void BenchMixRamp(const char* pName, MixRampFn fn, const int16* pSrc, int32* pAccum)
+{
+    int64 frames = 0;
+    int64 start = s3eTimerGetMs();
+    int64 elapsed;
+    do
+    {
+        // A fade from full volume to silence across each block
+        for (int i = 0; i < 64; i++)
+            fn(pSrc, pAccum, BENCH_MIX_FRAMES, 0x100 << 8, -(0x100 << 8) / BENCH_MIX_FRAMES);
+        frames += 64 * BENCH_MIX_FRAMES;
+        elapsed = s3eTimerGetMs() - start;
+    } while (elapsed < BENCH_MS);
+    Report(pName, frames, elapsed);
+}
+
+static void BenchMixStereo(const char* pName, MixStereoFn fn, const int16* pSrc, int32* pAccum)
+{
+    int64 frames = 0;
+    int64 start = s3eTimerGetMs();
+    int64 elapsed;
+    do
+    {
+        for (int i = 0; i < 64; i++)
+            fn(pSrc, pAccum, BENCH_MIX_FRAMES, 0xb5, 0x4b);
+        frames += 64 * BENCH_MIX_FRAMES;
+        elapsed = s3eTimerGetMs() - start;
+    } while (elapsed < BENCH_MS);
+    Report(pName, frames, elapsed);
+}
+
+static void BenchMixStereoRamp(const char* pName, MixStereoRampFn fn, const int16* pSrc, int32* pAccum)
+{
+    int64 frames = 0;
+    int64 start = s3eTimerGetMs();
+    int64 elapsed;
+    do
+    {
+        // A pan from hard left to hard right across each block
+        for (int i = 0; i < 64; i++)
+            fn(pSrc, pAccum, BENCH_MIX_FRAMES, 0x100 << 8, -(0x100 << 8) / BENCH_MIX_FRAMES,
+                0, (0x100 << 8) / BENCH_MIX_FRAMES);
+        frames += 64 * BENCH_MIX_FRAMES;
+        elapsed = s3eTimerGetMs() - start;
+    } while (elapsed < BENCH_MS);
+    Report(pName, frames, elapsed);
+}
+
+static void BenchMixClip(const char* pName, MixClipFn fn, const int32* pAccum, int16* pDst)
+{
+    int64 frames = 0;
+    int64 start = s3eTimerGetMs();
+    int64 elapsed;
+    do
+    {
+        for (int i = 0; i < 64; i++)
+            fn(pAccum, pDst, BENCH_MIX_FRAMES, true);
+        frames += 64 * BENCH_MIX_FRAMES;
+        elapsed = s3eTimerGetMs() - start;
+    } while (elapsed < BENCH_MS);
+    Report(pName, frames, elapsed);
+}
+
+static void BenchMix()
+{
+    s3eDebugTracePrintf("bench mix kernels (%s) self test: %s", MixKernelsTarget(),
+        MixKernelsSelfTest() ? "passed" : "FAILED");
+
+    static int16 src[BENCH_MIX_FRAMES];
+    static int16 dst[BENCH_MIX_FRAMES];
+    static int32 accum[BENCH_MIX_FRAMES * 2];
+    srand(3);
+    for (int i = 0; i < BENCH_MIX_FRAMES; i++)
+        src[i] = (int16)rand();
+
+    BenchMixMono("mix mono", MixMonoToMono, src, accum);
+    BenchMixMono("mix mono scalar", MixMonoToMonoScalar, src, accum);
+    BenchMixRamp("mix mono ramp", MixMonoToMonoRamp, src, accum);
+    BenchMixRamp("mix mono ramp scalar", MixMonoToMonoRampScalar, src, accum);
+    BenchMixStereo("mix mono->stereo", MixMonoToStereo, src, accum);
+    BenchMixStereo("mix mono->stereo scalar", MixMonoToStereoScalar, src, accum);
+    BenchMixStereoRamp("mix stereo ramp", MixMonoToStereoRamp, src, accum);
+    BenchMixStereoRamp("mix stereo ramp scalar", MixMonoToStereoRampScalar, src, accum);
+    BenchMixClip("clip", MixClip, accum, dst);
+    BenchMixClip("clip scalar", MixClipScalar, accum, dst);
+}
+
+// Source frames converted per pass, a little over a mixer block at 2:1
+#define BENCH_RESAMPLE_FRAMES   600
+
+typedef int (*ResampleFn)(Resampler* pResampler, int16* pDst, int frames);
+
+// Time the cost per output frame of converting @a inRate to @a outRate the
+// way the mixer does, a block at a time
+static void BenchResampleRate(const char* pName, ResampleFn fn, ResamplerQuality quality,
+    uint32 inRate, uint32 outRate)
+{
+    static int16 src[BENCH_RESAMPLE_FRAMES];
+    static int16 dst[BENCH_MIX_FRAMES];
+    static Resampler resampler;
+    static ResamplerFilter filter;
+
+    srand(5);
+    for (int i = 0; i < BENCH_RESAMPLE_FRAMES; i++)
+        src[i] = (int16)rand();
+    ResamplerBuildFilter(&filter, inRate, outRate);
+    ResamplerInit(&resampler, inRate, outRate, quality, &filter);
+
+    int64 frames = 0;
+    int64 start = s3eTimerGetMs();
+    int64 elapsed;
+    do
+    {
+        for (int i = 0; i < 64; i++)
+        {
+            int want = ResamplerNeeded(&resampler, BENCH_MIX_FRAMES);
+            ResamplerWrite(&resampler, src, want < BENCH_RESAMPLE_FRAMES ? want : BENCH_RESAMPLE_FRAMES);
+            frames += fn(&resampler, dst, BENCH_MIX_FRAMES);
+        }
+        elapsed = s3eTimerGetMs() - start;
+    } while (elapsed < BENCH_MS);
+    Report(pName, frames, elapsed);
+}
+
+static void BenchResample()
+{
+    s3eDebugTracePrintf("bench resampler (%s) self test: %s", MixKernelsTarget(),
+        ResamplerSelfTest() ? "passed" : "FAILED");
+
+    BenchResampleRate("resample linear 22k->44k", ResamplerRead, RESAMPLER_LINEAR, 22050, 44100);
+    BenchResampleRate("resample sinc 22k->44k", ResamplerRead, RESAMPLER_SINC, 22050, 44100);
+    BenchResampleRate("resample sinc scalar", ResamplerReadScalar, RESAMPLER_SINC, 22050, 44100);
+    BenchResampleRate("resample sinc 48k->44k", ResamplerRead, RESAMPLER_SINC, 48000, 44100);
+}
+
+// Run the master chain with only @a stage switched in, or none if
+// MASTEREFFECT_STAGES, over a loud stereo mix
+static void BenchEffectStage(const char* pName, int stage, int32* pMix, int32* pAccum)
+{
+    for (int i = 0; i < MASTEREFFECT_STAGES; i++)
+        MasterEffectsSetBypass((MasterEffectStage)i, i != stage);
+
+    int64 frames = 0;
+    int64 start = s3eTimerGetMs();
+    int64 elapsed;
+    do
+    {
+        for (int i = 0; i < 64; i++)
+        {
+            memcpy(pAccum, pMix, BENCH_MIX_FRAMES * 2 * sizeof(int32));
+            MasterEffectsProcess(pAccum, BENCH_MIX_FRAMES, 2);
+        }
+        frames += 64 * BENCH_MIX_FRAMES;
+        elapsed = s3eTimerGetMs() - start;
+    } while (elapsed < BENCH_MS);
+    Report(pName, frames, elapsed);
+}
+
+// Cost of each master effect, to budget the chain against. The copy of the
+// mix into the accumulator is included in every figure, so the bypassed
+// chain is the baseline.
+static void BenchEffects()
+{
+    if (!MasterEffectsInit(44100))
+        return;
+
+    // Several full scale voices summed, so every stage has work to do
+    static int32 mix[BENCH_MIX_FRAMES * 2];
+    static int32 accum[BENCH_MIX_FRAMES * 2];
+    srand(4);
+    for (int i = 0; i < BENCH_MIX_FRAMES * 2; i++)
+        mix[i] = (int16)rand() * 3;
+
+    BenchEffectStage("effects bypassed", MASTEREFFECT_STAGES, mix, accum);
+    BenchEffectStage("effect compressor", MASTEREFFECT_COMPRESSOR, mix, accum);
+    BenchEffectStage("effect reverb", MASTEREFFECT_REVERB, mix, accum);
+    BenchEffectStage("effect limiter", MASTEREFFECT_LIMITER, mix, accum);
+    MasterEffectsTerminate();
+}
+
+// Calls made into the SoundPool extension per timing pass
+#define BENCH_POOL_CALLS    1000
+
+static void BenchPoolCall(const char* pName, bool getError)
+{
+    int64 calls = 0;
+    int64 start = s3eTimerGetMs();
+    int64 elapsed;
+    do
+    {
+        for (int i = 0; i < BENCH_POOL_CALLS; i++)
+        {
+            if (getError)
+                s3eSoundPoolGetError();
+            else
+                s3eSoundPoolGetInt(S3E_SOUNDPOOL_VOLUME);
+        }
+        calls += BENCH_POOL_CALLS;
+        elapsed = s3eTimerGetMs() - start;
+    } while (elapsed < BENCH_MS);
+
+    int64 psPerCall = (elapsed > 0 ? elapsed : 1) * 1000000000 / calls;
+    s3eDebugTracePrintf("bench %-24s %6d.%03d ns/call", pName, (int)(psPerCall / 1000), (int)(psPerCall % 1000));
+}
+
+// Cost of a round trip into the SoundPool extension, which per frame status
+// polling pays for every pad. Build with S3E_SOUNDPOOL_TRACE_CALLS defined
+// to compare against the traced wrappers.
+static void BenchPool()
+{
+    if (!s3eSoundPoolAvailable())
+        return;
+
+    BenchPoolCall("pool get int", false);
+    BenchPoolCall("pool get error", true);
+}
+
+void SoundBenchRun()
+{
+    s3eConfigGetInt("SoundBoard", "BenchMHz", &g_BenchMHz);
+
+    BenchAdpcm();
+    BenchMix();
+    BenchResample();
+    BenchEffects();
+    BenchPool();
+}
@@ -0,0 +1,28 @@
+/*
+ * This file is part of the Marmalade SDK Code Samples.
+ *
+ * Copyright (C) 2001-2011 Ideaworks3D Ltd.
+ * All Rights Reserved.
+ *
+ * This source code is intended only as a supplement to Ideaworks Labs
+ * Development Tools and/or on-line documentation.
+ *
+ * THIS CODE AND INFORMATION ARE PROVIDED "AS IS" WITHOUT WARRANTY OF ANY
+ * KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+ * PARTICULAR PURPOSE.
+ */
+// On-device timing of the audio paths
+//-----------------------------------------------------------------------------
+
+#ifndef SOUND_BENCH_H
+#define SOUND_BENCH_H
+
+/**
+ * Time each benchmark on synthetic data and print the results to the
+ * trace output. Enabled with [SoundBoard] Benchmark=1.
+ * Also times calls into the SoundPool extension where it is available.
+ */
+void SoundBenchRun();
+
+#endif /* !SOUND_BENCH_H */
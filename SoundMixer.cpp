@@ -0,0 +1,1162 @@
+/*
+ * This file is part of the Marmalade SDK Code Samples.
+ *
+ * Copyright (C) 2001-2011 Ideaworks3D Ltd.
+ * All Rights Reserved.
+ *
+ * This source code is intended only as a supplement to Ideaworks Labs
+ * Development Tools and/or on-line documentation.
+ *
+ * THIS CODE AND INFORMATION ARE PROVIDED "AS IS" WITHOUT WARRANTY OF ANY
+ * KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+ * PARTICULAR PURPOSE.
+ */
+#include "SoundMixer.h"
+#include "SoundAtomic.h"
+#include "SoundQueue.h"
+#include "MixKernels.h"
+#include "MasterEffects.h"
+#include "Resampler.h"
+#include "SampleStream.h"
+#include "Adpcm.h"
+#include "s3eSound.h"
+#include "s3eDebug.h"
+#include "s3eTimer.h"
+#include <malloc.h>
+#include <memory.h>
+#include <math.h>
+
+#if SAMPLESTREAM_MAX_VOICES < SOUNDMIXER_MAX_VOICES
+#error every mixer voice needs a stream voice
+#endif
+
+/*
+ * The main thread and the audio callback only talk through two queues.
+ * Commands are applied by the callback at the start of each block, or held
+ * until the frame they are stamped with; events are delivered by
+ * SoundMixerUpdate() once per frame. A voice slot belongs to the main
+ * thread until its MIXCMD_PLAY is queued and comes back to it with the
+ * slot's MIXEVENT_END.
+ */
+enum
+{
+    MIXCMD_PLAY,
+    MIXCMD_STOP,
+    MIXCMD_PAUSE,
+    MIXCMD_RESUME,
+    MIXCMD_VOLUME,
+    MIXCMD_RESAMPLING,
+    MIXCMD_RATE,
+    MIXCMD_PAN,
+};
+
+enum
+{
+    MIXEVENT_END,
+};
+
+typedef struct MixCommand
+{
+    uint16  m_Type;
+    uint16  m_Slot;
+    int32   m_Value;
+    uint32  m_Generation;       // of the voice the command is for
+    uint64  m_When;             // mixer clock frame to apply at; earlier means straight away
+} MixCommand;
+
+typedef struct MixEvent
+{
+    uint16  m_Type;
+    uint16  m_Slot;
+} MixEvent;
+
+#define MIXER_COMMANDS      256
+
+// Commands held for a later frame. Any beyond this are applied straight away.
+#define MIXER_SCHEDULED     64
+
+// Each slot ends at most once per start, so this can never fill
+#define MIXER_EVENTS        64
+
+#if MIXER_EVENTS < SOUNDMIXER_MAX_VOICES
+#error the event queue must hold an end event for every voice
+#endif
+
+typedef enum MixSource
+{
+    MIXSOURCE_PCM,          // 16 bit mono in memory, read in place
+    MIXSOURCE_ADPCM,        // decoded a block at a time
+    MIXSOURCE_STREAM,       // read from the voice's stream ring
+} MixSource;
+
+// Handles carry the slot in the low bits and the slot's generation above,
+// so a handle to a voice that has ended never matches its slot's next use
+#define HANDLE_SLOT_BITS    8
+#define HANDLE_SLOT_MASK    ((1 << HANDLE_SLOT_BITS) - 1)
+#define HANDLE_GEN_MASK     0x7fffff
+
+// Sample stride used to estimate a voice's level for stealing
+#define LEVEL_STRIDE        16
+
+// Entries in the pan law, one per pan position
+#define PAN_POSITIONS       (SOUNDMIXER_PAN_RIGHT - SOUNDMIXER_PAN_LEFT + 1)
+
+// What happens when a voice's gain ramp reaches its target
+enum
+{
+    RAMPEND_NONE,
+    RAMPEND_PAUSE,
+    RAMPEND_STOP,
+};
+
+/*
+ * Voices are kept in one array and visited in order every block.
+ */
+typedef struct MixVoice
+{
+    // Callback only. Commands for a slot may still be in the queue after
+    // it has ended, so the main thread never writes these.
+    bool        m_Playing;
+    bool        m_Paused;
+    int32       m_Volume;       // gain once any ramp has finished, .8
+    int32       m_Gain;         // gain of the next frame, .16
+    int32       m_GainStep;     // added to m_Gain every frame while ramping
+    int32       m_RampTarget;   // .16
+    int         m_RampLeft;     // frames until m_Gain reaches m_RampTarget
+    int         m_RampEnd;
+    int32       m_Pan;          // pan position of the next frame, .16
+    int32       m_PanStep;      // added to m_Pan every frame while panning
+    int32       m_PanTarget;    // .16
+    int         m_PanLeft;      // frames until m_Pan reaches m_PanTarget
+    bool        m_PlayPending;  // MIXCMD_PLAY is held for m_PlayWhen
+    uint64      m_PlayWhen;
+    uint32      m_PlayGeneration;   // of the last MIXCMD_PLAY; other commands must match
+
+    // Written by the main thread before MIXCMD_PLAY, then read by the
+    // callback. Playback state in here belongs to the callback.
+    const SoundSample* m_pSample;
+    MixSource   m_Source;
+    uint32      m_NumFrames;
+    uint32      m_Pos;          // next source frame, except when streaming
+    uint32      m_LoopFrom;
+    uint32      m_LoopEnd;      // frame repeats jump back from
+    int32       m_RepeatsLeft;  // 0 repeats forever
+    AdpcmCursor m_Adpcm;
+    bool        m_Resample;     // sample rate differs from the output, or the rate was changed
+    bool        m_Flushed;      // source has ended and the resampler is draining
+    Resampler   m_Resampler;
+    int         m_FadeIn;       // frames to fade in over when started
+    int         m_FadeOut;      // frames to fade out over when stopped
+    int         m_RampFrames;   // frames to ramp volume changes, pauses and resumes over
+    int         m_StartPan;
+
+    // Written by the callback, read by the main thread for stealing. A
+    // single word, so never torn.
+    volatile uint32 m_Level;    // peak output of the last block, roughly
+
+    // Main thread only
+    bool        m_InUse;        // between SoundMixerPlay and its end event
+    bool        m_Stopping;     // stop queued
+    bool        m_Stolen;
+    uint32      m_Generation;
+    uint32      m_StartOrder;
+    int         m_Priority;
+    int         m_UserId;
+} MixVoice;
+
+static MixVoice g_MixVoices[SOUNDMIXER_MAX_VOICES];
+static int g_MixChannel = -1;
+static SoundMixerEndFn g_MixEndFn = NULL;
+static void* g_MixEndData = NULL;
+static int g_MixPolyphony = SOUNDMIXER_MAX_VOICES / 2;
+static SoundMixerStealPolicy g_MixStealPolicy = SOUNDMIXER_STEAL_OLDEST;
+static uint32 g_MixStartOrder = 0;
+static uint32 g_MixSteals = 0;
+static SoundQueue g_MixCommands;
+static SoundQueue g_MixEvents;
+static uint32 g_MixOutputRate = 0;
+static ResamplerQuality g_MixResampling = RESAMPLER_SINC;
+static int g_MixRampFrames = SOUNDMIXER_RAMP_FRAMES;
+static int g_MixOutputBuffers = 2;
+
+// Output timing, written by the callback. Single words, so never torn.
+static volatile int g_MixCallbackFrames = 0;
+static volatile int g_MixMaxCallbackFrames = 0;
+static volatile uint32 g_MixCallbacks = 0;
+static volatile uint32 g_MixUnderruns = 0;
+static int64 g_MixLastCallbackMs = 0;
+
+// Frames mixed since SoundMixerInit(). Written by the callback only.
+static volatile uint64 g_MixClock = 0;
+
+// Commands waiting for their frame, in the order they arrived. Callback only.
+static MixCommand g_MixScheduled[MIXER_SCHEDULED];
+static int g_MixNumScheduled = 0;
+
+// Decode buffers for compressed samples, one per voice, allocated up front
+// so starting a voice never allocates
+static int16* g_MixDecoded = NULL;
+
+// Constant power pan law: left and right gain at each pan position, 1.15
+static uint16 g_MixPanLaw[PAN_POSITIONS][2];
+
+// Audio callback scratch. The accumulator is interleaved when stereo.
+static int32 g_MixAccum[SOUNDMIXER_BLOCK_FRAMES * 2];
+static int16 g_MixScratch[SOUNDMIXER_BLOCK_FRAMES];
+static int16 g_MixResampled[SOUNDMIXER_BLOCK_FRAMES];
+
+// Placeholder passed to s3eSoundChannelPlay; the callback supplies the data
+static int16 g_MixSilence[16];
+
+//-----------------------------------------------------------------------------
+// Audio callback
+//-----------------------------------------------------------------------------
+static void Seek(MixVoice* v, uint32 frame)
+{
+    if (v->m_Source == MIXSOURCE_ADPCM)
+        AdpcmCursorSeek(&v->m_Adpcm, v->m_pSample, frame);
+    v->m_Pos = frame;
+}
+
+// Next run of up to @a frames source frames of @a v, following loops.
+// Every pass but the last stops at the loop end; the last plays on to the
+// end of the sample. Returns 0 with *pEnded set once the sample has
+// finished; 0 alone is a stream underrun. A loop that yields nothing right
+// after seeking back to its start would spin for ever, so it ends the voice.
+static int ReadSource(MixVoice* v, int frames, const int16** ppSrc, bool* pEnded)
+{
+    *pEnded = false;
+    if (frames <= 0)
+        return 0;
+
+    bool looped = false;
+    for (;;)
+    {
+        uint32 left = (v->m_RepeatsLeft == 1 ? v->m_NumFrames : v->m_LoopEnd) - v->m_Pos;
+        int want = (uint32)frames < left ? frames : (int)left;
+
+        int n = 0;
+        switch (v->m_Source)
+        {
+        case MIXSOURCE_PCM:
+            n = want;
+            *ppSrc = v->m_pSample->m_Data + v->m_Pos;
+            break;
+
+        case MIXSOURCE_ADPCM:
+            n = want ? AdpcmCursorRead(&v->m_Adpcm, want, ppSrc) : 0;
+            break;
+
+        case MIXSOURCE_STREAM:
+            // The reader handles looping
+            *ppSrc = g_MixScratch;
+            n = SampleStreamRead(v - g_MixVoices, g_MixScratch, frames, pEnded);
+            if (n)
+                *pEnded = false;
+            return n;
+        }
+
+        v->m_Pos += n;
+        if (n)
+            return n;
+        if (v->m_RepeatsLeft == 1 || looped)
+        {
+            *pEnded = true;
+            return 0;
+        }
+        if (v->m_RepeatsLeft > 1)
+            v->m_RepeatsLeft--;
+        Seek(v, v->m_LoopFrom);
+        looped = true;
+    }
+}
+
+// Land a ramp on its target. Returns false if the voice should end.
+static bool FinishRamp(MixVoice* v)
+{
+    v->m_Gain = v->m_RampTarget;
+    v->m_RampLeft = 0;
+
+    int end = v->m_RampEnd;
+    v->m_RampEnd = RAMPEND_NONE;
+    if (end == RAMPEND_PAUSE)
+        v->m_Paused = true;
+    return end != RAMPEND_STOP;
+}
+
+// Move the gain linearly to @a volume over @a frames frames, then do @a end.
+// Returns false if the voice should end straight away.
+static bool StartRamp(MixVoice* v, int32 volume, int frames, int end)
+{
+    v->m_RampTarget = volume << 8;
+    v->m_RampEnd = end;
+    if (frames <= 0)
+        return FinishRamp(v);
+
+    v->m_GainStep = (v->m_RampTarget - v->m_Gain) / frames;
+    v->m_RampLeft = frames;
+    return true;
+}
+
+// Move the pan position linearly to @a pan over @a frames frames
+static void StartPan(MixVoice* v, int pan, int frames)
+{
+    v->m_PanTarget = pan << 16;
+    if (frames <= 0)
+    {
+        v->m_Pan = v->m_PanTarget;
+        v->m_PanLeft = 0;
+        return;
+    }
+
+    v->m_PanStep = (v->m_PanTarget - v->m_Pan) / frames;
+    v->m_PanLeft = frames;
+}
+
+// Gain of each side, .16, for @a gain16 at pan position @a pan16
+static inline void PanGains(int32 gain16, int32 pan16, int32* pLeft, int32* pRight)
+{
+    const uint16* law = g_MixPanLaw[((pan16 + 0x8000) >> 16) - SOUNDMIXER_PAN_LEFT];
+    *pLeft = (int32)(((int64)gain16 * law[0]) >> 15);
+    *pRight = (int32)(((int64)gain16 * law[1]) >> 15);
+}
+
+// Mix @a n frames of @a v into the interleaved stereo accumulator. The side
+// gains are worked out at both ends of the run from gain and pan, so a run
+// with neither ramping is two multiply-accumulates a frame.
+static void MixVoiceStereo(MixVoice* v, const int16* pSrc, int32* pAccum, int n)
+{
+    int32 endGain = v->m_Gain + (v->m_RampLeft ? n * v->m_GainStep : 0);
+    int32 endPan = v->m_Pan + (v->m_PanLeft ? n * v->m_PanStep : 0);
+
+    int32 left, right, endLeft, endRight;
+    PanGains(v->m_Gain, v->m_Pan, &left, &right);
+    PanGains(endGain, endPan, &endLeft, &endRight);
+
+    if (left == endLeft && right == endRight)
+        MixMonoToStereo(pSrc, pAccum, n, left >> 8, right >> 8);
+    else
+        MixMonoToStereoRamp(pSrc, pAccum, n, left, (endLeft - left) / n, right, (endRight - right) / n);
+}
+
+// Add @a frames frames of @a v to @a pAccum. Returns false once the voice
+// has played to the end, or finished fading out.
+static bool MixVoiceBlock(MixVoice* v, int32* pAccum, int frames, bool stereo)
+{
+    int32 peak = 0;
+    int done = 0;
+
+    while (done < frames)
+    {
+        const int16* pSrc = NULL;
+        bool ended = false;
+        int n;
+
+        // Reads stop where a ramp ends, so each run is mixed at one gain or
+        // along one ramp
+        int limit = frames - done;
+        if (v->m_RampLeft && v->m_RampLeft < limit)
+            limit = v->m_RampLeft;
+        if (v->m_PanLeft && v->m_PanLeft < limit)
+            limit = v->m_PanLeft;
+
+        if (v->m_Resample)
+        {
+            // Read converted frames until the resampler runs dry, then
+            // top it up with just enough source for the rest of the block
+            pSrc = g_MixResampled;
+            n = ResamplerRead(&v->m_Resampler, g_MixResampled, limit);
+            if (!n)
+            {
+                if (v->m_Flushed)
+                    ended = true;
+                else
+                {
+                    int want = ResamplerNeeded(&v->m_Resampler, limit);
+                    if (want > SOUNDMIXER_BLOCK_FRAMES)
+                        want = SOUNDMIXER_BLOCK_FRAMES;
+
+                    const int16* pIn;
+                    int got = ReadSource(v, want, &pIn, &ended);
+                    if (got)
+                        ResamplerWrite(&v->m_Resampler, pIn, got);
+                    else if (ended)
+                        ResamplerFlush(&v->m_Resampler);
+                    v->m_Flushed = ended;
+                    if (got || ended)
+                    {
+                        ended = false;
+                        continue;
+                    }
+                }
+            }
+        }
+        else
+        {
+            n = ReadSource(v, limit, &pSrc, &ended);
+        }
+
+        if (ended)
+        {
+            SoundAtomicStore(&v->m_Level, 0);
+            return false;
+        }
+
+        // A short read without the end is an underrun; the rest of the
+        // block is left silent
+        if (!n)
+            break;
+
+        for (int i = 0; i < n; i += LEVEL_STRIDE)
+        {
+            int32 a = pSrc[i] < 0 ? -pSrc[i] : pSrc[i];
+            if (a > peak)
+                peak = a;
+        }
+
+        if (stereo)
+            MixVoiceStereo(v, pSrc, pAccum + done * 2, n);
+        else if (!v->m_RampLeft)
+            MixMonoToMono(pSrc, pAccum + done, n, v->m_Gain >> 8);
+        else
+            MixMonoToMonoRamp(pSrc, pAccum + done, n, v->m_Gain, v->m_GainStep);
+
+        if (v->m_PanLeft)
+        {
+            v->m_Pan += n * v->m_PanStep;
+            v->m_PanLeft -= n;
+            if (!v->m_PanLeft)
+                v->m_Pan = v->m_PanTarget;
+        }
+
+        if (!v->m_RampLeft)
+        {
+            done += n;
+            continue;
+        }
+
+        v->m_Gain += n * v->m_GainStep;
+        v->m_RampLeft -= n;
+        done += n;
+
+        if (!v->m_RampLeft)
+        {
+            // Faded out or paused: the rest of the block is left silent
+            if (!FinishRamp(v))
+                return false;
+            if (v->m_Paused)
+                break;
+        }
+    }
+
+    SoundAtomicStore(&v->m_Level, (peak * (v->m_Gain >> 8)) >> 8);
+    return true;
+}
+
+static void EndVoice(int slot)
+{
+    g_MixVoices[slot].m_Playing = false;
+    SoundAtomicStore(&g_MixVoices[slot].m_Level, 0);
+
+    MixEvent e;
+    e.m_Type = MIXEVENT_END;
+    e.m_Slot = (uint16)slot;
+    SoundQueuePush(&g_MixEvents, &e);
+}
+
+static void ApplyCommand(const MixCommand* c)
+{
+    MixVoice* v = &g_MixVoices[c->m_Slot];
+
+    // Anything but a start is stale once the voice has ended
+    if (c->m_Type != MIXCMD_PLAY && !v->m_Playing)
+        return;
+
+    switch (c->m_Type)
+    {
+    case MIXCMD_PLAY:
+        v->m_Playing = true;
+        v->m_Paused = false;
+        v->m_Volume = c->m_Value;
+        v->m_Gain = v->m_FadeIn > 0 ? 0 : v->m_Volume << 8;
+        v->m_RampLeft = 0;
+        v->m_RampEnd = RAMPEND_NONE;
+        StartRamp(v, v->m_Volume, v->m_FadeIn, RAMPEND_NONE);
+        StartPan(v, v->m_StartPan, 0);
+        break;
+    case MIXCMD_STOP:
+        // A paused voice is already silent
+        if (v->m_Paused || !StartRamp(v, 0, v->m_FadeOut, RAMPEND_STOP))
+            EndVoice(c->m_Slot);
+        break;
+    case MIXCMD_PAUSE:
+        if (!v->m_Paused && v->m_RampEnd == RAMPEND_NONE)
+            StartRamp(v, 0, v->m_RampFrames, RAMPEND_PAUSE);
+        break;
+    case MIXCMD_RESUME:
+        if (v->m_Paused || v->m_RampEnd == RAMPEND_PAUSE)
+        {
+            v->m_Paused = false;
+            StartRamp(v, v->m_Volume, v->m_RampFrames, RAMPEND_NONE);
+        }
+        break;
+    case MIXCMD_VOLUME:
+        // Paused and fading voices pick the new volume up when resumed
+        v->m_Volume = c->m_Value;
+        if (!v->m_Paused && v->m_RampEnd == RAMPEND_NONE)
+            StartRamp(v, v->m_Volume, v->m_RampFrames, RAMPEND_NONE);
+        break;
+    case MIXCMD_RESAMPLING:
+        ResamplerSetQuality(&v->m_Resampler, (ResamplerQuality)c->m_Value);
+        break;
+    case MIXCMD_RATE:
+        // Once the position is fractional the voice stays on the
+        // resampler, even back at the normal rate
+        ResamplerSetRate(&v->m_Resampler, c->m_Value);
+        v->m_Resample = true;
+        break;
+    case MIXCMD_PAN:
+        StartPan(v, c->m_Value, v->m_Paused ? 0 : v->m_RampFrames);
+        break;
+    }
+}
+
+// Hold @a c until its frame. Returns false if there is no room.
+static bool Schedule(const MixCommand* c)
+{
+    if (g_MixNumScheduled == MIXER_SCHEDULED)
+        return false;
+
+    g_MixScheduled[g_MixNumScheduled++] = *c;
+    if (c->m_Type == MIXCMD_PLAY)
+    {
+        MixVoice* v = &g_MixVoices[c->m_Slot];
+        v->m_PlayPending = true;
+        v->m_PlayWhen = c->m_When;
+        v->m_PlayGeneration = c->m_Generation;
+    }
+    return true;
+}
+
+// Drop the held start of the voice in @a slot, ending it without a sound
+static void CancelPlay(int slot)
+{
+    for (int i = 0; i < g_MixNumScheduled; i++)
+    {
+        if (g_MixScheduled[i].m_Slot == slot && g_MixScheduled[i].m_Type == MIXCMD_PLAY)
+        {
+            memmove(&g_MixScheduled[i], &g_MixScheduled[i + 1], (g_MixNumScheduled - i - 1) * sizeof(MixCommand));
+            g_MixNumScheduled--;
+            break;
+        }
+    }
+    g_MixVoices[slot].m_PlayPending = false;
+    EndVoice(slot);
+}
+
+// Apply @a c now, unless its voice has yet to start
+static void Dispatch(const MixCommand* c)
+{
+    MixVoice* v = &g_MixVoices[c->m_Slot];
+    if (c->m_Type == MIXCMD_PLAY)
+    {
+        v->m_PlayPending = false;
+        v->m_PlayGeneration = c->m_Generation;
+    }
+    else if (c->m_Generation != v->m_PlayGeneration)
+    {
+        // Held for a voice that has since ended; its slot may be in use again
+        return;
+    }
+    else if (v->m_PlayPending)
+    {
+        // Stopping a voice before it starts means it never sounds. Anything
+        // else waits, and is applied straight after the start.
+        if (c->m_Type == MIXCMD_STOP)
+        {
+            CancelPlay(c->m_Slot);
+            return;
+        }
+
+        MixCommand later = *c;
+        later.m_When = v->m_PlayWhen;
+        if (Schedule(&later))
+            return;
+    }
+    ApplyCommand(c);
+}
+
+static void ApplyCommands()
+{
+    MixCommand c;
+    while (SoundQueuePop(&g_MixCommands, &c))
+    {
+        // With no room to hold it, a command is applied early rather than lost
+        if (c.m_When > g_MixClock && Schedule(&c))
+            continue;
+        Dispatch(&c);
+    }
+}
+
+// Apply the held commands whose frame has come, in the order they arrived.
+// Dispatching can remove other held commands, so the scan starts again
+// after each one. A voice's start always arrived before its other
+// commands, so a command held back for a start due now is never reached
+// before that start.
+static void ApplyDue()
+{
+    int i = 0;
+    while (i < g_MixNumScheduled)
+    {
+        if (g_MixScheduled[i].m_When > g_MixClock)
+        {
+            i++;
+            continue;
+        }
+
+        MixCommand c = g_MixScheduled[i];
+        memmove(&g_MixScheduled[i], &g_MixScheduled[i + 1], (g_MixNumScheduled - i - 1) * sizeof(MixCommand));
+        g_MixNumScheduled--;
+        Dispatch(&c);
+        i = 0;
+    }
+}
+
+// Frames from the clock until the next held command is due, at most @a frames
+static int NextDue(int frames)
+{
+    for (int i = 0; i < g_MixNumScheduled; i++)
+    {
+        uint64 due = g_MixScheduled[i].m_When - g_MixClock;
+        if (due < (uint64)frames)
+            frames = (int)due;
+    }
+    return frames;
+}
+
+static void MixVoices(int32* pAccum, int frames, bool stereo)
+{
+    for (int i = 0; i < SOUNDMIXER_MAX_VOICES; i++)
+    {
+        MixVoice* v = &g_MixVoices[i];
+        if (!v->m_Playing)
+            continue;
+
+        if (v->m_Paused)
+            SoundAtomicStore(&v->m_Level, 0);
+        else if (!MixVoiceBlock(v, pAccum, frames, stereo))
+            EndVoice(i);
+    }
+}
+
+static int32 GenAudio(s3eSoundGenAudioInfo* pInfo, void* userData)
+{
+    int16* pTarget = pInfo->m_Target;
+    uint32 left = pInfo->m_NumSamples;
+    bool stereo = pInfo->m_Stereo != 0;
+    int channels = stereo ? 2 : 1;
+
+    // The device asks for the next buffer while the others are still
+    // queued. If it asks later than those would last, it has run dry.
+    int64 now = s3eTimerGetMs();
+    if (g_MixCallbacks && g_MixOutputRate)
+    {
+        int64 queuedMs = (int64)left * g_MixOutputBuffers * 1000 / g_MixOutputRate;
+        if (now - g_MixLastCallbackMs > queuedMs + 1)
+            g_MixUnderruns++;
+    }
+    g_MixLastCallbackMs = now;
+    g_MixCallbackFrames = left;
+    if ((int)left > g_MixMaxCallbackFrames)
+        g_MixMaxCallbackFrames = left;
+    g_MixCallbacks++;
+
+    while (left)
+    {
+        int frames = left < SOUNDMIXER_BLOCK_FRAMES ? left : SOUNDMIXER_BLOCK_FRAMES;
+        memset(g_MixAccum, 0, frames * channels * sizeof(int32));
+
+        ApplyCommands();
+
+        // The block is split where held commands fall due, so voices start
+        // and stop on their exact frame
+        int done = 0;
+        while (done < frames)
+        {
+            int n = NextDue(frames - done);
+            MixVoices(g_MixAccum + done * channels, n, stereo);
+            g_MixClock += n;
+            done += n;
+            ApplyDue();
+        }
+
+        MasterEffectsProcess(g_MixAccum, frames, channels);
+
+        // Saturate into the output, on top of whatever is there if mixing
+        MixClip(g_MixAccum, pTarget, frames * channels, pInfo->m_Mix != 0);
+
+        pTarget += frames * channels;
+        left -= frames;
+    }
+
+    // The channel never ends; voices end individually
+    return pInfo->m_NumSamples;
+}
+
+//-----------------------------------------------------------------------------
+// Main thread
+//-----------------------------------------------------------------------------
+bool SoundMixerInit(int channel, SoundMixerEndFn endFn, void* userData)
+{
+    SoundMixerTerminate();
+
+    g_MixEndFn = endFn;
+    g_MixEndData = userData;
+    g_MixCallbackFrames = g_MixMaxCallbackFrames = 0;
+    g_MixCallbacks = g_MixUnderruns = 0;
+    g_MixClock = 0;
+    g_MixOutputRate = s3eSoundGetInt(S3E_SOUND_OUTPUT_FREQ);
+    if (!g_MixOutputRate)
+        g_MixOutputRate = s3eSoundGetInt(S3E_SOUND_DEFAULT_FREQ);
+
+    g_MixDecoded = (int16*)malloc(SOUNDMIXER_MAX_VOICES * ADPCM_MAX_BLOCK_FRAMES * sizeof(int16));
+    if (!g_MixDecoded || !MasterEffectsInit(g_MixOutputRate) || !SoundQueueInit(&g_MixCommands, sizeof(MixCommand), MIXER_COMMANDS) ||
+        !SoundQueueInit(&g_MixEvents, sizeof(MixEvent), MIXER_EVENTS))
+    {
+        SoundMixerTerminate();
+        return false;
+    }
+    for (int i = 0; i < SOUNDMIXER_MAX_VOICES; i++)
+        g_MixVoices[i].m_Adpcm.m_Decoded = g_MixDecoded + i * ADPCM_MAX_BLOCK_FRAMES;
+
+    // Quarter sine and cosine, so left^2 + right^2 is constant
+    for (int i = 0; i < PAN_POSITIONS; i++)
+    {
+        double angle = (i * 1.5707963267948966) / (PAN_POSITIONS - 1);
+        g_MixPanLaw[i][0] = (uint16)(cos(angle) * 32768 + 0.5);
+        g_MixPanLaw[i][1] = (uint16)(sin(angle) * 32768 + 0.5);
+    }
+
+    // The same callback fills the channel in stereo when the device is
+    // set up for it
+    bool stereo = s3eSoundGetInt(S3E_SOUND_STEREO_ENABLED) != 0;
+    if (s3eSoundChannelRegister(channel, S3E_CHANNEL_GEN_AUDIO, (s3eCallback)GenAudio, NULL) ||
+        (stereo && s3eSoundChannelRegister(channel, S3E_CHANNEL_GEN_AUDIO_STEREO, (s3eCallback)GenAudio, NULL)) ||
+        s3eSoundChannelPlay(channel, g_MixSilence, sizeof(g_MixSilence)/sizeof(int16), 0, 0))
+    {
+        s3eDebugTracePrintf("mixer: can't start channel %d", channel);
+        s3eSoundChannelUnRegister(channel, S3E_CHANNEL_GEN_AUDIO);
+        s3eSoundChannelUnRegister(channel, S3E_CHANNEL_GEN_AUDIO_STEREO);
+        SoundMixerTerminate();
+        return false;
+    }
+
+    g_MixChannel = channel;
+    return true;
+}
+
+void SoundMixerSetPolyphony(int maxVoices, SoundMixerStealPolicy policy)
+{
+    if (maxVoices < 1)
+        maxVoices = 1;
+    else if (maxVoices > SOUNDMIXER_MAX_VOICES)
+        maxVoices = SOUNDMIXER_MAX_VOICES;
+
+    g_MixPolyphony = maxVoices;
+    g_MixStealPolicy = policy;
+}
+
+void SoundMixerSetResampling(ResamplerQuality quality)
+{
+    g_MixResampling = quality;
+}
+
+void SoundMixerSetRampFrames(int frames)
+{
+    g_MixRampFrames = frames > 0 ? frames : 0;
+}
+
+void SoundMixerSetOutputBuffers(int buffers)
+{
+    g_MixOutputBuffers = buffers > 0 ? buffers : 1;
+}
+
+void SoundMixerGetOutputStats(SoundMixerOutputStats* pStats)
+{
+    pStats->m_BufferFrames = g_MixCallbackFrames;
+    pStats->m_MaxBufferFrames = g_MixMaxCallbackFrames;
+    pStats->m_Buffers = g_MixOutputBuffers;
+    pStats->m_LatencyMs = g_MixOutputRate ? pStats->m_BufferFrames * pStats->m_Buffers * 1000 / (int)g_MixOutputRate : 0;
+    pStats->m_Callbacks = g_MixCallbacks;
+    pStats->m_Underruns = g_MixUnderruns;
+}
+
+void SoundMixerPlayParamsInit(SoundMixerPlayParams* pParams)
+{
+    pParams->m_Repeat = 1;
+    pParams->m_LoopFrom = -1;
+    pParams->m_LoopEnd = -1;
+    pParams->m_UserId = 0;
+    pParams->m_Priority = 0;
+    pParams->m_Volume = SOUNDMIXER_MAX_VOLUME;
+    pParams->m_FadeIn = 0;
+    pParams->m_FadeOut = -1;
+    pParams->m_Pan = SOUNDMIXER_PAN_CENTRE;
+    pParams->m_Rate = SOUNDMIXER_RATE_NORMAL;
+    pParams->m_StartFrame = 0;
+}
+
+// Slot of the voice @a voice refers to, or -1 if it has ended
+static int GetSlot(int voice)
+{
+    int slot = voice & HANDLE_SLOT_MASK;
+    if (voice < 0 || slot >= SOUNDMIXER_MAX_VOICES)
+        return -1;
+
+    MixVoice* v = &g_MixVoices[slot];
+    if (!v->m_InUse || v->m_Generation != (uint32)voice >> HANDLE_SLOT_BITS)
+        return -1;
+    return slot;
+}
+
+static bool Send(int type, int slot, uint32 generation, int32 value, uint64 when = 0)
+{
+    MixCommand c;
+    c.m_Type = (uint16)type;
+    c.m_Slot = (uint16)slot;
+    c.m_Value = value;
+    c.m_Generation = generation;
+    c.m_When = when;
+    return SoundQueuePush(&g_MixCommands, &c);
+}
+
+static s3eResult SendToVoice(int type, int voice, int32 value, uint64 when = 0)
+{
+    int slot = GetSlot(voice);
+    if (slot < 0 || g_MixVoices[slot].m_Stopping || !Send(type, slot, g_MixVoices[slot].m_Generation, value, when))
+        return S3E_RESULT_ERROR;
+    return S3E_RESULT_SUCCESS;
+}
+
+// A voice that is sounding, or paused, and has not been told to stop
+static bool IsAudible(const MixVoice* v)
+{
+    return v->m_InUse && !v->m_Stopping;
+}
+
+// Pick the voice to make way for a new one of @a priority, or NULL
+static MixVoice* ChooseVictim(int priority)
+{
+    MixVoice* pVictim = NULL;
+    for (int i = 0; i < SOUNDMIXER_MAX_VOICES; i++)
+    {
+        MixVoice* v = &g_MixVoices[i];
+        if (!IsAudible(v))
+            continue;
+        if (!pVictim)
+        {
+            pVictim = v;
+            continue;
+        }
+
+        bool better = false;
+        switch (g_MixStealPolicy)
+        {
+        case SOUNDMIXER_STEAL_QUIETEST:
+            better = v->m_Level < pVictim->m_Level ||
+                (v->m_Level == pVictim->m_Level && v->m_StartOrder < pVictim->m_StartOrder);
+            break;
+        case SOUNDMIXER_STEAL_PRIORITY:
+            better = v->m_Priority < pVictim->m_Priority ||
+                (v->m_Priority == pVictim->m_Priority && v->m_StartOrder < pVictim->m_StartOrder);
+            break;
+        default:
+            better = v->m_StartOrder < pVictim->m_StartOrder;
+            break;
+        }
+        if (better)
+            pVictim = v;
+    }
+
+    if (pVictim && g_MixStealPolicy == SOUNDMIXER_STEAL_PRIORITY && pVictim->m_Priority > priority)
+        return NULL;
+    return pVictim;
+}
+
+int SoundMixerPlay(const SoundSample* pSample, int32 repeat, int32 loopfrom, int userId, int priority)
+{
+    SoundMixerPlayParams params;
+    SoundMixerPlayParamsInit(&params);
+    params.m_Repeat = repeat;
+    params.m_LoopFrom = loopfrom;
+    params.m_UserId = userId;
+    params.m_Priority = priority;
+    return SoundMixerPlayEx(pSample, &params);
+}
+
+int SoundMixerPlayEx(const SoundSample* pSample, const SoundMixerPlayParams* pParams)
+{
+    int32 repeat = pParams->m_Repeat;
+    int32 loopfrom = pParams->m_LoopFrom;
+    int32 loopend = pParams->m_LoopEnd;
+    int priority = pParams->m_Priority;
+
+    uint32 numFrames = pSample->m_DataLen / sizeof(int16);
+    if (g_MixChannel < 0 || !numFrames || pParams->m_Volume < 0 || pParams->m_Volume > SOUNDMIXER_MAX_VOLUME ||
+        pParams->m_Pan < SOUNDMIXER_PAN_LEFT || pParams->m_Pan > SOUNDMIXER_PAN_RIGHT ||
+        pParams->m_Rate <= 0 || pParams->m_Rate > SOUNDMIXER_MAX_RATE)
+        return -1;
+
+    // Stolen voices keep their slot until the callback lets go of them, so
+    // there are more slots than the polyphony limit
+    int slot = 0;
+    while (slot < SOUNDMIXER_MAX_VOICES && g_MixVoices[slot].m_InUse)
+        slot++;
+    if (slot == SOUNDMIXER_MAX_VOICES)
+        return -1;
+
+    int audible = 0;
+    for (int i = 0; i < SOUNDMIXER_MAX_VOICES; i++)
+    {
+        if (IsAudible(&g_MixVoices[i]))
+            audible++;
+    }
+
+    // The victim is only stopped once nothing else can fail, so a play
+    // that fails leaves every other voice playing
+    MixVoice* pVictim = NULL;
+    if (audible >= g_MixPolyphony)
+    {
+        pVictim = g_MixStealPolicy != SOUNDMIXER_STEAL_NONE ? ChooseVictim(priority) : NULL;
+        if (!pVictim)
+            return -1;
+    }
+
+    MixVoice* v = &g_MixVoices[slot];
+    // The sample's own loop is used unless one is given. Repeats jump
+    // within the sample's data, so a looped sample costs no more memory
+    // than its intro and loop body.
+    if (loopend < 0)
+        loopend = pSample->m_LoopEnd;
+    if (loopfrom < 0)
+        loopfrom = pSample->m_LoopEnd ? pSample->m_LoopStart : 0;
+    if (loopend == 0 || (uint32)loopend > numFrames)
+        loopend = numFrames;
+    if (loopfrom >= loopend)
+        loopfrom = 0;
+
+    v->m_pSample = pSample;
+    v->m_NumFrames = numFrames;
+    v->m_LoopFrom = loopfrom;
+    v->m_LoopEnd = loopend;
+    v->m_RepeatsLeft = repeat;
+    v->m_Level = 0;
+    v->m_FadeIn = pParams->m_FadeIn;
+    v->m_FadeOut = pParams->m_FadeOut < 0 ? g_MixRampFrames : pParams->m_FadeOut;
+    v->m_RampFrames = g_MixRampFrames;
+    v->m_StartPan = pParams->m_Pan;
+
+    if (pSample->m_Storage == SOUNDSAMPLE_STORAGE_STREAM)
+    {
+        v->m_Source = MIXSOURCE_STREAM;
+        if (SampleStreamStart(slot, pSample, repeat, loopfrom, loopend))
+            return -1;
+    }
+    else if (pSample->m_Codec == SOUNDSAMPLE_CODEC_IMA_ADPCM)
+    {
+        v->m_Source = MIXSOURCE_ADPCM;
+    }
+    else
+    {
+        v->m_Source = MIXSOURCE_PCM;
+    }
+    Seek(v, 0);
+
+    // Samples at another rate are converted as they play. The resampler
+    // is set up for every voice so the playback rate can be changed later.
+    uint32 rate = pSample->m_SampleRate ? pSample->m_SampleRate : g_MixOutputRate;
+    v->m_Resample = rate != g_MixOutputRate;
+    v->m_Flushed = false;
+    ResamplerInit(&v->m_Resampler, rate, g_MixOutputRate, g_MixResampling,
+        ResamplerGetFilter(rate, g_MixOutputRate));
+    if (pParams->m_Rate != SOUNDMIXER_RATE_NORMAL)
+    {
+        ResamplerSetRate(&v->m_Resampler, pParams->m_Rate);
+        v->m_Resample = true;
+    }
+
+    bool stolen = pVictim && Send(MIXCMD_STOP, pVictim - g_MixVoices, pVictim->m_Generation, 0);
+    if (stolen)
+    {
+        pVictim->m_Stopping = true;
+        pVictim->m_Stolen = true;
+        g_MixSteals++;
+    }
+
+    uint32 generation = (v->m_Generation + 1) & HANDLE_GEN_MASK;
+    if ((pVictim && !stolen) || !Send(MIXCMD_PLAY, slot, generation, pParams->m_Volume, pParams->m_StartFrame))
+    {
+        if (v->m_Source == MIXSOURCE_STREAM)
+            SampleStreamStop(slot);
+        return -1;
+    }
+
+    v->m_InUse = true;
+    v->m_Stopping = false;
+    v->m_Stolen = false;
+    v->m_Generation = generation;
+    v->m_StartOrder = g_MixStartOrder++;
+    v->m_Priority = priority;
+    v->m_UserId = pParams->m_UserId;
+    return slot | (v->m_Generation << HANDLE_SLOT_BITS);
+}
+
+s3eResult SoundMixerStop(int voice)
+{
+    return SoundMixerStopAt(voice, 0);
+}
+
+s3eResult SoundMixerStopAt(int voice, uint64 frame)
+{
+    if (SendToVoice(MIXCMD_STOP, voice, 0, frame))
+        return S3E_RESULT_ERROR;
+
+    g_MixVoices[voice & HANDLE_SLOT_MASK].m_Stopping = true;
+    return S3E_RESULT_SUCCESS;
+}
+
+s3eResult SoundMixerPause(int voice)
+{
+    return SendToVoice(MIXCMD_PAUSE, voice, 0);
+}
+
+s3eResult SoundMixerResume(int voice)
+{
+    return SendToVoice(MIXCMD_RESUME, voice, 0);
+}
+
+s3eResult SoundMixerSetVolume(int voice, int volume)
+{
+    if (volume < 0 || volume > SOUNDMIXER_MAX_VOLUME)
+        return S3E_RESULT_ERROR;
+    return SendToVoice(MIXCMD_VOLUME, voice, volume);
+}
+
+s3eResult SoundMixerSetPan(int voice, int pan)
+{
+    if (pan < SOUNDMIXER_PAN_LEFT || pan > SOUNDMIXER_PAN_RIGHT)
+        return S3E_RESULT_ERROR;
+    return SendToVoice(MIXCMD_PAN, voice, pan);
+}
+
+s3eResult SoundMixerSetVoiceResampling(int voice, ResamplerQuality quality)
+{
+    return SendToVoice(MIXCMD_RESAMPLING, voice, quality);
+}
+
+s3eResult SoundMixerSetRate(int voice, int32 rate)
+{
+    if (rate <= 0 || rate > SOUNDMIXER_MAX_RATE)
+        return S3E_RESULT_ERROR;
+    return SendToVoice(MIXCMD_RATE, voice, rate);
+}
+
+bool SoundMixerIsPlaying(const SoundSample* pSample)
+{
+    for (int i = 0; i < SOUNDMIXER_MAX_VOICES; i++)
+    {
+        if (g_MixVoices[i].m_InUse && g_MixVoices[i].m_pSample == pSample)
+            return true;
+    }
+    return false;
+}
+
+int SoundMixerGetActiveVoices()
+{
+    int count = 0;
+    for (int i = 0; i < SOUNDMIXER_MAX_VOICES; i++)
+    {
+        if (IsAudible(&g_MixVoices[i]))
+            count++;
+    }
+    return count;
+}
+
+uint32 SoundMixerGetSteals()
+{
+    return g_MixSteals;
+}
+
+uint64 SoundMixerGetClock()
+{
+    // Two words on 32 bit targets, so read until the callback isn't part
+    // way through a write
+    uint64 clock;
+    do
+        clock = g_MixClock;
+    while (clock != g_MixClock);
+    return clock;
+}
+
+uint32 SoundMixerGetOutputRate()
+{
+    return g_MixOutputRate;
+}
+
+static void FreeVoice(int slot)
+{
+    MixVoice* v = &g_MixVoices[slot];
+    if (v->m_Source == MIXSOURCE_STREAM)
+        SampleStreamStop(slot);
+    v->m_pSample = NULL;
+    v->m_InUse = false;
+}
+
+void SoundMixerUpdate()
+{
+    MixEvent e;
+    while (SoundQueuePop(&g_MixEvents, &e))
+    {
+        MixVoice* v = &g_MixVoices[e.m_Slot];
+
+        SoundMixerEndInfo info;
+        info.m_Voice = e.m_Slot | (v->m_Generation << HANDLE_SLOT_BITS);
+        info.m_UserId = v->m_UserId;
+        info.m_Stolen = v->m_Stolen;
+        FreeVoice(e.m_Slot);
+
+        if (g_MixEndFn)
+            g_MixEndFn(&info, g_MixEndData);
+    }
+}
+
+void SoundMixerTerminate()
+{
+    if (g_MixChannel >= 0)
+    {
+        // Once stopped the callback no longer runs and every voice is ours
+        s3eSoundChannelStop(g_MixChannel);
+        s3eSoundChannelUnRegister(g_MixChannel, S3E_CHANNEL_GEN_AUDIO);
+        s3eSoundChannelUnRegister(g_MixChannel, S3E_CHANNEL_GEN_AUDIO_STEREO);
+        g_MixChannel = -1;
+    }
+
+    for (int i = 0; i < SOUNDMIXER_MAX_VOICES; i++)
+    {
+        MixVoice* v = &g_MixVoices[i];
+        if (v->m_InUse)
+            FreeVoice(i);
+        v->m_Playing = false;
+        v->m_PlayPending = false;
+        v->m_Adpcm.m_Decoded = NULL;
+    }
+    g_MixNumScheduled = 0;
+    free(g_MixDecoded);
+    g_MixDecoded = NULL;
+
+    SoundQueueDestroy(&g_MixCommands);
+    SoundQueueDestroy(&g_MixEvents);
+    ResamplerTerminate();
+    MasterEffectsTerminate();
+}
@@ -0,0 +1,262 @@
+/*
+ * This file is part of the Marmalade SDK Code Samples.
+ *
+ * Copyright (C) 2001-2011 Ideaworks3D Ltd.
+ * All Rights Reserved.
+ *
+ * This source code is intended only as a supplement to Ideaworks Labs
+ * Development Tools and/or on-line documentation.
+ *
+ * THIS CODE AND INFORMATION ARE PROVIDED "AS IS" WITHOUT WARRANTY OF ANY
+ * KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+ * PARTICULAR PURPOSE.
+ */
+// Software mixer: any number of voices played through one sound channel
+//-----------------------------------------------------------------------------
+
+#ifndef SOUND_MIXER_H
+#define SOUND_MIXER_H
+
+#include "s3eTypes.h"
+#include "SoundSample.h"
+#include "Resampler.h"
+
+// Voice slots. Voices that have been stolen hold on to their slot until
+// the audio callback has let go of them, so the polyphony limit set with
+// SoundMixerSetPolyphony() should leave some slots spare.
+#define SOUNDMIXER_MAX_VOICES   32
+
+// Frames mixed per pass of the audio callback
+#define SOUNDMIXER_BLOCK_FRAMES 256
+
+// Voice volume at which samples play unchanged (as S3E_SOUNDPOOL_MAX_VOLUME)
+#define SOUNDMIXER_MAX_VOLUME   0x100
+
+// Default length of the ramps volume changes, pauses, resumes and stops
+// are smoothed with, in frames
+#define SOUNDMIXER_RAMP_FRAMES  256
+
+// Pan positions, from hard left to hard right (as S3E_SOUNDPOOL_PAN_LEFT and
+// S3E_SOUNDPOOL_PAN_RIGHT)
+#define SOUNDMIXER_PAN_LEFT     -0x100
+#define SOUNDMIXER_PAN_CENTRE   0
+#define SOUNDMIXER_PAN_RIGHT    0x100
+
+// Playback rates, 16.16 fixed point (as S3E_SOUNDPOOL_RATE_NORMAL)
+#define SOUNDMIXER_RATE_NORMAL  RESAMPLER_RATE_NORMAL
+#define SOUNDMIXER_MAX_RATE     (4 * SOUNDMIXER_RATE_NORMAL)
+
+/**
+ * Passed to the end callback when a voice finishes, or is stopped.
+ */
+typedef struct SoundMixerEndInfo
+{
+    int     m_Voice;            // handle returned by SoundMixerPlay
+    int     m_UserId;           // as given to SoundMixerPlay
+    bool    m_Stolen;           // stopped to make way for another voice
+} SoundMixerEndInfo;
+
+/**
+ * What SoundMixerPlay() does when the polyphony limit has been reached.
+ */
+typedef enum SoundMixerStealPolicy
+{
+    SOUNDMIXER_STEAL_NONE,      // fail to start the new voice
+    SOUNDMIXER_STEAL_OLDEST,    // stop the voice that started first
+    SOUNDMIXER_STEAL_QUIETEST,  // stop the voice that is currently quietest
+    SOUNDMIXER_STEAL_PRIORITY,  // stop the oldest of the lowest priority voices,
+                                // unless it outranks the new voice
+} SoundMixerStealPolicy;
+
+/**
+ * How the device is pulling audio from the mixer.
+ */
+typedef struct SoundMixerOutputStats
+{
+    int     m_BufferFrames;     // frames asked for by the last callback
+    int     m_MaxBufferFrames;  // most frames asked for by one callback
+    int     m_Buffers;          // as SoundMixerSetOutputBuffers()
+    int     m_LatencyMs;        // estimated from the above and the output rate
+    uint32  m_Callbacks;
+    uint32  m_Underruns;        // callbacks that came after the queued audio ran out
+} SoundMixerOutputStats;
+
+typedef int32 (*SoundMixerEndFn)(SoundMixerEndInfo* pInfo, void* userData);
+
+/**
+ * Everything SoundMixerPlayEx() can be told about a new voice.
+ * SoundMixerPlayParamsInit() fills in the defaults.
+ */
+typedef struct SoundMixerPlayParams
+{
+    int32   m_Repeat;           // as s3eSoundChannelPlay; 0 repeats forever (default 1)
+    int32   m_LoopFrom;         // frame repeats start from (default -1, the
+                                // sample's loop start, or 0 if it has no loop)
+    int32   m_LoopEnd;          // frame after the last one repeated; 0 repeats
+                                // to the end (default -1, the sample's loop end)
+    int     m_UserId;           // passed back when the voice ends (default 0)
+    int     m_Priority;         // used by SOUNDMIXER_STEAL_PRIORITY (default 0)
+    int     m_Volume;           // 0 to SOUNDMIXER_MAX_VOLUME (default SOUNDMIXER_MAX_VOLUME)
+    int     m_FadeIn;           // frames to fade in over (default 0, start at full volume)
+    int     m_FadeOut;          // frames to fade out over when stopped or stolen
+                                // (default -1, the ramp length)
+    int     m_Pan;              // SOUNDMIXER_PAN_LEFT to SOUNDMIXER_PAN_RIGHT
+                                // (default SOUNDMIXER_PAN_CENTRE)
+    int32   m_Rate;             // playback rate, as SoundMixerSetRate(), from
+                                // the first frame (default SOUNDMIXER_RATE_NORMAL)
+    uint64  m_StartFrame;       // SoundMixerGetClock() frame to start on
+                                // (default 0, straight away)
+} SoundMixerPlayParams;
+
+/**
+ * Start mixing into @a channel. @a endFn is called from SoundMixerUpdate()
+ * for each voice that has ended. Mixes to a stereo bus, with each voice
+ * panned, when the device has stereo output enabled; otherwise pan is
+ * ignored. The mix goes through the master effects chain, every stage of
+ * which starts out bypassed.
+ */
+bool SoundMixerInit(int channel, SoundMixerEndFn endFn, void* userData);
+
+/**
+ * Limit the number of voices sounding at once to @a maxVoices (at most
+ * SOUNDMIXER_MAX_VOICES) and choose how a voice is found once the limit is
+ * reached. Defaults to half the slots and SOUNDMIXER_STEAL_OLDEST.
+ */
+void SoundMixerSetPolyphony(int maxVoices, SoundMixerStealPolicy policy);
+
+/**
+ * Length in frames of the linear ramps used for volume changes, pauses and
+ * resumes of voices started from now on, and for stopping them unless a
+ * fade out is given. 0 applies changes as a step.
+ * Defaults to SOUNDMIXER_RAMP_FRAMES.
+ */
+void SoundMixerSetRampFrames(int frames);
+
+/**
+ * Conversion used for voices started from now on whose sample rate differs
+ * from the output rate. Defaults to RESAMPLER_SINC.
+ */
+void SoundMixerSetResampling(ResamplerQuality quality);
+
+/**
+ * Number of callback buffers the device keeps queued, used to estimate
+ * output latency and to spot underruns. s3eSound chooses the buffer size
+ * itself, so this should be what the platform is known to use.
+ * Defaults to 2.
+ */
+void SoundMixerSetOutputBuffers(int buffers);
+
+void SoundMixerGetOutputStats(SoundMixerOutputStats* pStats);
+
+/**
+ * Start a voice playing @a pSample, which may be in memory, compressed or
+ * streamed, at any sample rate. @a repeat and @a loopfrom behave as for s3eSoundChannelPlay,
+ * except that repeats stop short at the end of the sample's loop, if it has
+ * one, and the last pass plays on to the end of the sample.
+ * The same sample may be playing on any number of voices. @a userId is
+ * passed back when the voice ends; @a priority is used by
+ * SOUNDMIXER_STEAL_PRIORITY. In-memory samples start without allocating
+ * or touching the file system. A streamed sample opens its file, and the
+ * first stream on each voice slot allocates that slot's ring buffer. No
+ * voice is stolen unless the new one can start.
+ * @return a handle to the new voice, or -1 if no voice could be found.
+ * Calls on the handle of a voice that has ended fail rather than affect
+ * whichever voice reuses its slot.
+ */
+int SoundMixerPlay(const SoundSample* pSample, int32 repeat, int32 loopfrom, int userId, int priority);
+
+void SoundMixerPlayParamsInit(SoundMixerPlayParams* pParams);
+
+/**
+ * As SoundMixerPlay(), with fades, a starting volume, pan and rate, and
+ * optionally a frame to start on. A voice given a start frame can be
+ * controlled straight away; changes are applied as it starts, and stopping
+ * it first means it never sounds.
+ */
+int SoundMixerPlayEx(const SoundSample* pSample, const SoundMixerPlayParams* pParams);
+
+/**
+ * Stop, pause or resume @a voice. Each fades over the voice's ramp length
+ * (or fade out, for a stop) rather than cutting in or out mid-waveform.
+ * The voice ends, and its slot is freed, once the fade out has finished.
+ */
+s3eResult SoundMixerStop(int voice);
+s3eResult SoundMixerPause(int voice);
+s3eResult SoundMixerResume(int voice);
+
+/**
+ * Stop @a voice on SoundMixerGetClock() frame @a frame, or straight away if
+ * that has passed. Its fade out starts on that frame. The voice no longer
+ * counts towards the polyphony limit once this is called.
+ */
+s3eResult SoundMixerStopAt(int voice, uint64 frame);
+
+/**
+ * Ramp the volume of @a voice to @a volume, from 0 to SOUNDMIXER_MAX_VOLUME.
+ * There is no need to call this every frame to fade a voice.
+ */
+s3eResult SoundMixerSetVolume(int voice, int volume);
+
+/**
+ * Move @a voice to @a pan, from SOUNDMIXER_PAN_LEFT to SOUNDMIXER_PAN_RIGHT,
+ * over its ramp length. Pan is constant power: a voice sounds as loud at
+ * either side as in the centre.
+ */
+s3eResult SoundMixerSetPan(int voice, int pan);
+
+/**
+ * Change the conversion quality of @a voice while it plays. Has no effect
+ * on voices at the output rate and normal playback rate.
+ */
+s3eResult SoundMixerSetVoiceResampling(int voice, ResamplerQuality quality);
+
+/**
+ * Change the playback rate, and so the pitch, of @a voice while it plays,
+ * up to SOUNDMIXER_MAX_RATE. The sample is read at a fractional position
+ * and interpolated; its data is never copied or converted. At most
+ * RESAMPLER_MAX_STEP source frames are read per output frame, so a sample
+ * above the output rate tops out lower: at 44.1 kHz into 22.05 kHz output,
+ * rates past 4 times normal play at 4 times.
+ */
+s3eResult SoundMixerSetRate(int voice, int32 rate);
+
+/**
+ * Returns true while any voice is still playing, or paused on, @a pSample.
+ */
+bool SoundMixerIsPlaying(const SoundSample* pSample);
+
+/**
+ * Number of voices currently sounding or paused.
+ */
+int SoundMixerGetActiveVoices();
+
+/**
+ * Number of voices stopped to make way for others.
+ */
+uint32 SoundMixerGetSteals();
+
+/**
+ * Frames mixed since SoundMixerInit(), counting up at the output rate
+ * without gaps. Start and stop frames are given on this clock, and act on
+ * exactly that frame if it has yet to be mixed.
+ */
+uint64 SoundMixerGetClock();
+
+/**
+ * Rate the clock counts at: the device's output rate, or its default rate
+ * where the output rate is not reported. 0 before SoundMixerInit().
+ */
+uint32 SoundMixerGetOutputRate();
+
+/**
+ * Deliver end notifications and free ended voices. Call once per frame.
+ */
+void SoundMixerUpdate();
+
+/**
+ * Stop the mixer channel and every voice.
+ */
+void SoundMixerTerminate();
+
+#endif /* !SOUND_MIXER_H */
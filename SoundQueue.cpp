@@ -0,0 +1,67 @@
+/*
+ * This file is part of the Marmalade SDK Code Samples.
+ *
+ * Copyright (C) 2001-2011 Ideaworks3D Ltd.
+ * All Rights Reserved.
+ *
+ * This source code is intended only as a supplement to Ideaworks Labs
+ * Development Tools and/or on-line documentation.
+ *
+ * THIS CODE AND INFORMATION ARE PROVIDED "AS IS" WITHOUT WARRANTY OF ANY
+ * KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+ * PARTICULAR PURPOSE.
+ */
+#include "SoundQueue.h"
+#include "SoundAtomic.h"
+#include <malloc.h>
+#include <memory.h>
+
+bool SoundQueueInit(SoundQueue* pQueue, uint32 itemSize, uint32 capacity)
+{
+    memset(pQueue, 0, sizeof(SoundQueue));
+    if (!capacity || (capacity & (capacity - 1)))
+        return false;
+
+    pQueue->m_pItems = (uint8*)malloc(itemSize * capacity);
+    if (!pQueue->m_pItems)
+        return false;
+
+    pQueue->m_ItemSize = itemSize;
+    pQueue->m_Mask = capacity - 1;
+    return true;
+}
+
+void SoundQueueDestroy(SoundQueue* pQueue)
+{
+    free(pQueue->m_pItems);
+    memset(pQueue, 0, sizeof(SoundQueue));
+}
+
+bool SoundQueuePush(SoundQueue* pQueue, const void* pItem)
+{
+    // Only this side writes m_Write, so it can be read without a barrier
+    uint32 write = pQueue->m_Write;
+    if (!pQueue->m_pItems || write - SoundAtomicLoad(&pQueue->m_Read) > pQueue->m_Mask)
+        return false;
+
+    memcpy(pQueue->m_pItems + (write & pQueue->m_Mask) * pQueue->m_ItemSize, pItem, pQueue->m_ItemSize);
+    SoundAtomicStore(&pQueue->m_Write, write + 1);
+    return true;
+}
+
+bool SoundQueuePop(SoundQueue* pQueue, void* pItem)
+{
+    uint32 read = pQueue->m_Read;
+    if (!pQueue->m_pItems || read == SoundAtomicLoad(&pQueue->m_Write))
+        return false;
+
+    memcpy(pItem, pQueue->m_pItems + (read & pQueue->m_Mask) * pQueue->m_ItemSize, pQueue->m_ItemSize);
+    SoundAtomicStore(&pQueue->m_Read, read + 1);
+    return true;
+}
+
+void SoundQueueClear(SoundQueue* pQueue)
+{
+    pQueue->m_Read = pQueue->m_Write;
+}
@@ -0,0 +1,61 @@
+/*
+ * This file is part of the Marmalade SDK Code Samples.
+ *
+ * Copyright (C) 2001-2011 Ideaworks3D Ltd.
+ * All Rights Reserved.
+ *
+ * This source code is intended only as a supplement to Ideaworks Labs
+ * Development Tools and/or on-line documentation.
+ *
+ * THIS CODE AND INFORMATION ARE PROVIDED "AS IS" WITHOUT WARRANTY OF ANY
+ * KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+ * PARTICULAR PURPOSE.
+ */
+// Lock-free single producer/single consumer queue of fixed size items
+//-----------------------------------------------------------------------------
+
+#ifndef SOUND_QUEUE_H
+#define SOUND_QUEUE_H
+
+#include "s3eTypes.h"
+
+/*
+ * Exactly one thread may push and exactly one thread may pop. Neither side
+ * ever blocks or allocates, so either may be the audio callback.
+ */
+typedef struct SoundQueue
+{
+    uint8*  m_pItems;
+    uint32  m_ItemSize;
+    uint32  m_Mask;             // capacity - 1
+    volatile uint32 m_Write;    // items pushed, free running
+    volatile uint32 m_Read;     // items popped, free running
+} SoundQueue;
+
+/**
+ * Allocate room for @a capacity items of @a itemSize bytes. @a capacity
+ * must be a power of two.
+ */
+bool SoundQueueInit(SoundQueue* pQueue, uint32 itemSize, uint32 capacity);
+
+void SoundQueueDestroy(SoundQueue* pQueue);
+
+/**
+ * Producer side. Copies @a pItem into the queue.
+ * @return false if the queue is full.
+ */
+bool SoundQueuePush(SoundQueue* pQueue, const void* pItem);
+
+/**
+ * Consumer side. Copies the oldest item to @a pItem and removes it.
+ * @return false if the queue is empty.
+ */
+bool SoundQueuePop(SoundQueue* pQueue, void* pItem);
+
+/**
+ * Discard everything in the queue. Only safe while neither side is in use.
+ */
+void SoundQueueClear(SoundQueue* pQueue);
+
+#endif /* !SOUND_QUEUE_H */
@@ -0,0 +1,93 @@
+/*
+ * This file is part of the Marmalade SDK Code Samples.
+ *
+ * Copyright (C) 2001-2011 Ideaworks3D Ltd.
+ * All Rights Reserved.
+ *
+ * This source code is intended only as a supplement to Ideaworks Labs
+ * Development Tools and/or on-line documentation.
+ *
+ * THIS CODE AND INFORMATION ARE PROVIDED "AS IS" WITHOUT WARRANTY OF ANY
+ * KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+ * PARTICULAR PURPOSE.
+ */
+#include "SoundSample.h"
+#include "SampleStream.h"
+#include <malloc.h>
+#include <memory.h>
+
+#ifdef SOUNDSAMPLE_HAVE_MMAP
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+void SoundSampleInit(SoundSample* pSample)
+{
+    memset(pSample, 0, sizeof(SoundSample));
+}
+
+void* SoundSampleMapFile(const char* filename, int* pSize)
+{
+#ifdef SOUNDSAMPLE_HAVE_MMAP
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0)
+        return NULL;
+
+    struct stat st;
+    if (fstat(fd, &st) || st.st_size <= 0)
+    {
+        close(fd);
+        return NULL;
+    }
+
+    void* base = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // The mapping holds its own reference to the file
+    close(fd);
+    if (base == MAP_FAILED)
+        return NULL;
+
+    *pSize = (int)st.st_size;
+    return base;
+#else
+    return NULL;
+#endif
+}
+
+void SoundSampleUnmapFile(void* pBase, int size)
+{
+#ifdef SOUNDSAMPLE_HAVE_MMAP
+    munmap(pBase, size);
+#endif
+}
+
+int SoundSampleResidentBytes(const SoundSample* pSample)
+{
+    if (pSample->m_Storage != SOUNDSAMPLE_STORAGE_HEAP && pSample->m_Storage != SOUNDSAMPLE_STORAGE_MAPPED)
+        return 0;
+
+    return pSample->m_Codec == SOUNDSAMPLE_CODEC_PCM ? pSample->m_DataLen : pSample->m_EncodedLen;
+}
+
+void SoundSampleRelease(SoundSample* pSample)
+{
+    switch (pSample->m_Storage)
+    {
+    case SOUNDSAMPLE_STORAGE_HEAP:
+        free(pSample->m_Data);
+        free((void*)pSample->m_pEncoded);
+        break;
+    case SOUNDSAMPLE_STORAGE_MAPPED:
+        SoundSampleUnmapFile(pSample->m_MapBase, pSample->m_MapLen);
+        break;
+    case SOUNDSAMPLE_STORAGE_STREAM:
+        SampleStreamSourceDestroy(pSample->m_pStream);
+        break;
+    default:
+        break;
+    }
+
+    SoundSampleInit(pSample);
+}
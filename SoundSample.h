@@ -0,0 +1,98 @@
+/*
+ * This file is part of the Marmalade SDK Code Samples.
+ *
+ * Copyright (C) 2001-2011 Ideaworks3D Ltd.
+ * All Rights Reserved.
+ *
+ * This source code is intended only as a supplement to Ideaworks Labs
+ * Development Tools and/or on-line documentation.
+ *
+ * THIS CODE AND INFORMATION ARE PROVIDED "AS IS" WITHOUT WARRANTY OF ANY
+ * KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+ * PARTICULAR PURPOSE.
+ */
+// Loaded sample handle
+//-----------------------------------------------------------------------------
+
+#ifndef SOUND_SAMPLE_H
+#define SOUND_SAMPLE_H
+
+#include "s3eTypes.h"
+
+// Memory mapping is only used where the C runtime provides mmap. Everywhere
+// else samples are read into a heap buffer.
+#if !defined(SOUNDSAMPLE_HAVE_MMAP) && (defined(__linux__) || defined(__APPLE__))
+#define SOUNDSAMPLE_HAVE_MMAP 1
+#endif
+
+struct SampleStreamSource;
+
+typedef enum SoundSampleStorage
+{
+    SOUNDSAMPLE_STORAGE_NONE = 0,
+    SOUNDSAMPLE_STORAGE_HEAP,       // m_Data or m_pEncoded was malloc'd and is owned by the sample
+    SOUNDSAMPLE_STORAGE_MAPPED,     // m_Data or m_pEncoded points into a read-only file mapping
+    SOUNDSAMPLE_STORAGE_STREAM,     // no resident data; played from disk through m_pStream
+    SOUNDSAMPLE_STORAGE_BANK,       // data borrowed from a SoundBank, which owns it
+} SoundSampleStorage;
+
+typedef enum SoundSampleCodec
+{
+    SOUNDSAMPLE_CODEC_PCM = 0,          // m_Data holds 16 bit mono PCM
+    SOUNDSAMPLE_CODEC_IMA_ADPCM,        // m_pEncoded holds IMA-ADPCM blocks
+} SoundSampleCodec;
+
+/**
+ * A loaded sample. The PCM data stays valid until SoundSampleRelease() is
+ * called on the handle, whatever storage backs it. Streamed and compressed
+ * samples have no m_Data; m_DataLen is then the size the data would have
+ * decoded in memory.
+ */
+typedef struct SoundSample
+{
+    int16*              m_Data;         // 16 bit mono PCM
+    int                 m_DataLen;      // size of m_Data in bytes
+    uint32              m_SampleRate;   // frames per second of m_Data
+    SoundSampleStorage  m_Storage;
+    void*               m_MapBase;      // start of the mapping (MAPPED only)
+    int                 m_MapLen;       // length of the mapping (MAPPED only)
+    SampleStreamSource* m_pStream;      // file to stream from (STREAM only)
+
+    // Compressed samples (m_Codec other than PCM)
+    SoundSampleCodec    m_Codec;
+    const uint8*        m_pEncoded;
+    int                 m_EncodedLen;
+    uint16              m_BlockAlign;   // bytes per encoded block
+    uint16              m_NumChannels;  // channels in the encoded data
+    int                 m_FramesPerBlock;
+
+    // Loop region from the file, in frames. Played in place: repeats jump
+    // back from m_LoopEnd to m_LoopStart rather than the data being copied.
+    uint32              m_LoopStart;
+    uint32              m_LoopEnd;      // frame after the loop, 0 if the sample has none
+} SoundSample;
+
+void SoundSampleInit(SoundSample* pSample);
+
+/**
+ * Map @a filename read-only. Returns NULL where mapping is unsupported or
+ * fails; callers then fall back to reading the file.
+ */
+void* SoundSampleMapFile(const char* filename, int* pSize);
+
+void SoundSampleUnmapFile(void* pBase, int size);
+
+/**
+ * Bytes of sample data the handle keeps in memory. Borrowed and streamed
+ * samples report 0.
+ */
+int SoundSampleResidentBytes(const SoundSample* pSample);
+
+/**
+ * Free or unmap the sample data and reset the handle.
+ * Safe to call on a handle that was never loaded.
+ */
+void SoundSampleRelease(SoundSample* pSample);
+
+#endif /* !SOUND_SAMPLE_H */
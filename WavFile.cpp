@@ -0,0 +1,540 @@
+/*
+ * This file is part of the Marmalade SDK Code Samples.
+ *
+ * Copyright (C) 2001-2011 Ideaworks3D Ltd.
+ * All Rights Reserved.
+ *
+ * This source code is intended only as a supplement to Ideaworks Labs
+ * Development Tools and/or on-line documentation.
+ *
+ * THIS CODE AND INFORMATION ARE PROVIDED "AS IS" WITHOUT WARRANTY OF ANY
+ * KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+ * PARTICULAR PURPOSE.
+ */
+#include "WavFile.h"
+#include "SampleConvert.h"
+#include "Adpcm.h"
+#include "s3eDebug.h"
+#include <stdio.h>
+#include <string.h>
+#include <malloc.h>
+
+
+// Frames converted per pass of WavConvertFrames
+#define WAV_CONVERT_BLOCK   128
+
+// Bytes of source data read per pass when converting from a file
+#define WAV_READ_BLOCK      0x4000
+
+// smpl chunk layout: a fixed header, then 24 byte loop records
+#define WAV_SMPL_HEADER     36
+#define WAV_SMPL_NUM_LOOPS  28
+#define WAV_SMPL_LOOP_START 8       // within a loop record
+#define WAV_SMPL_LOOP_END   12      // inclusive
+
+//-----------------------------------------------------------------------------
+// Parsing
+//-----------------------------------------------------------------------------
+static bool ParseAdpcmFormat(const FormatChunk* pFc, const uint8* pFmt, uint32 size, WavInfo* pInfo)
+{
+    int channels = pFc->m_NumberOfChannels;
+    int align = pFc->m_BlockAlign;
+
+    if (pFc->m_SignificantBits != 4 || channels < 1 || channels > ADPCM_MAX_CHANNELS ||
+        pFc->m_SampleRate == 0 || align <= 4 * channels || (align - 4 * channels) % (4 * channels))
+    {
+        s3eDebugTracePrintf("wav: bad IMA-ADPCM fmt chunk (%d channels, align %d)", channels, align);
+        return false;
+    }
+
+    int frames = AdpcmBlockFrames(align, channels);
+    if (frames > ADPCM_MAX_BLOCK_FRAMES || (size >= 20 && (pFmt[18] | (pFmt[19] << 8)) != frames))
+    {
+        s3eDebugTracePrintf("wav: unsupported IMA-ADPCM block size %d", align);
+        return false;
+    }
+
+    pInfo->m_Format = WAV_FORMAT_IMA_ADPCM;
+    pInfo->m_NumChannels = channels;
+    pInfo->m_SampleRate = pFc->m_SampleRate;
+    pInfo->m_BlockAlign = align;
+    pInfo->m_BitsPerSample = 4;
+    pInfo->m_FramesPerBlock = frames;
+    return true;
+}
+
+static bool ParseFormat(WavReadFn readFn, void* pCtx, uint32 offset, uint32 size, WavInfo* pInfo)
+{
+    // The standard fields of FormatChunk, plus the WAVE_FORMAT_EXTENSIBLE
+    // extension up to the first two bytes of its sub format GUID. For
+    // IMA-ADPCM bytes 18-19 are the frames per block instead.
+    uint8 fmt[26];
+    const uint32 basicSize = sizeof(FormatChunk) - sizeof(Chunk);
+
+    if (size < basicSize)
+    {
+        s3eDebugTracePrintf("wav: fmt chunk too small (%u)", size);
+        return false;
+    }
+
+    uint32 readSize = size < sizeof(fmt) ? size : sizeof(fmt);
+    if (!readFn(pCtx, offset, fmt, readSize))
+        return false;
+
+    FormatChunk fc;
+    memcpy(&fc.m_CompressionCode, fmt, basicSize);
+
+    uint16 format = fc.m_CompressionCode;
+    if (format == WAV_FORMAT_EXTENSIBLE)
+    {
+        if (readSize < sizeof(fmt))
+        {
+            s3eDebugTracePrintf("wav: truncated extensible fmt chunk");
+            return false;
+        }
+        format = (uint16)(fmt[24] | (fmt[25] << 8));
+    }
+
+    uint16 bits = fc.m_SignificantBits;
+    bool ok;
+    if (format == WAV_FORMAT_IMA_ADPCM)
+        return ParseAdpcmFormat(&fc, fmt, readSize, pInfo);
+    else if (format == WAV_FORMAT_PCM)
+        ok = bits == 8 || bits == 16 || bits == 24 || bits == 32;
+    else if (format == WAV_FORMAT_FLOAT)
+        ok = bits == 32;
+    else
+        ok = false;
+
+    if (!ok)
+    {
+        s3eDebugTracePrintf("wav: unsupported format 0x%x, %d bits", format, bits);
+        return false;
+    }
+
+    if (fc.m_NumberOfChannels < 1 || fc.m_NumberOfChannels > WAV_MAX_CHANNELS ||
+        fc.m_SampleRate == 0 ||
+        fc.m_BlockAlign != fc.m_NumberOfChannels * (bits / 8))
+    {
+        s3eDebugTracePrintf("wav: bad fmt chunk (%d channels, %u Hz, align %d)",
+            fc.m_NumberOfChannels, fc.m_SampleRate, fc.m_BlockAlign);
+        return false;
+    }
+
+    pInfo->m_Format = format;
+    pInfo->m_NumChannels = fc.m_NumberOfChannels;
+    pInfo->m_SampleRate = fc.m_SampleRate;
+    pInfo->m_BlockAlign = fc.m_BlockAlign;
+    pInfo->m_BitsPerSample = bits;
+    return true;
+}
+
+static inline uint32 ReadLE32(const uint8* p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32)p[3] << 24);
+}
+
+// Take the first loop of a smpl chunk. Samplers only ever loop one region,
+// so any others are ignored, and every loop type is played forwards.
+static bool ParseSampler(WavReadFn readFn, void* pCtx, uint32 offset, uint32 size, WavInfo* pInfo)
+{
+    uint8 smpl[WAV_SMPL_HEADER + 16];
+    if (size < sizeof(smpl))
+        return true;
+
+    if (!readFn(pCtx, offset, smpl, sizeof(smpl)))
+        return false;
+
+    if (ReadLE32(smpl + WAV_SMPL_NUM_LOOPS))
+    {
+        uint32 start = ReadLE32(smpl + WAV_SMPL_HEADER + WAV_SMPL_LOOP_START);
+        uint32 end = ReadLE32(smpl + WAV_SMPL_HEADER + WAV_SMPL_LOOP_END);
+        if (start <= end && end != 0xffffffff)
+        {
+            pInfo->m_LoopStart = start;
+            pInfo->m_LoopEnd = end + 1;
+        }
+    }
+    return true;
+}
+
+// The smpl chunk may come before the fmt chunk, so its loop is only checked
+// against the data once both are known
+static void CheckLoop(WavInfo* pInfo)
+{
+    if (!pInfo->m_LoopEnd)
+        return;
+
+    uint32 frames = WavNumFrames(pInfo);
+    if (pInfo->m_LoopEnd > frames)
+    {
+        s3eDebugTracePrintf("wav: loop %u-%u runs past the end, dropped", pInfo->m_LoopStart, pInfo->m_LoopEnd);
+        pInfo->m_LoopStart = 0;
+        pInfo->m_LoopEnd = 0;
+    }
+}
+
+bool WavParse(WavReadFn readFn, void* pCtx, uint32 fileSize, WavInfo* pInfo)
+{
+    RiffHeader header;
+    memset(pInfo, 0, sizeof(WavInfo));
+
+    if (fileSize < sizeof(header) || !readFn(pCtx, 0, &header, sizeof(header)))
+        return false;
+
+    if (strncmp(header.m_ChunkID, "RIFF", 4) || strncmp(header.m_RIFFType, "WAVE", 4))
+    {
+        s3eDebugTracePrintf("wav: not a RIFF/WAVE file");
+        return false;
+    }
+
+    // Some writers leave the RIFF size at 0 or -1, so only ever trust it to
+    // shorten the file
+    uint32 end = fileSize;
+    if (header.m_ChunkSize > 0 && (uint32)header.m_ChunkSize + 8 < end)
+        end = (uint32)header.m_ChunkSize + 8;
+
+    bool gotFormat = false;
+    bool gotData = false;
+    uint32 offset = sizeof(header);
+    while (offset + sizeof(Chunk) <= end)
+    {
+        Chunk chunk;
+        if (!readFn(pCtx, offset, &chunk, sizeof(chunk)))
+            return false;
+        offset += sizeof(chunk);
+
+        uint32 avail = end - offset;
+        if (!strncmp(chunk.m_ChunkID, "fmt ", 4))
+        {
+            if (chunk.m_ChunkSize > avail || !ParseFormat(readFn, pCtx, offset, chunk.m_ChunkSize, pInfo))
+                return false;
+            gotFormat = true;
+        }
+        else if (!strncmp(chunk.m_ChunkID, "smpl", 4))
+        {
+            if (!ParseSampler(readFn, pCtx, offset, chunk.m_ChunkSize < avail ? chunk.m_ChunkSize : avail, pInfo))
+                return false;
+        }
+        else if (!strncmp(chunk.m_ChunkID, "data", 4) && !gotData)
+        {
+            if (!gotFormat)
+            {
+                s3eDebugTracePrintf("wav: data chunk before fmt chunk");
+                return false;
+            }
+
+            // Tolerate a truncated final chunk, but only keep whole frames.
+            // The last ADPCM block may legitimately be short.
+            uint32 len = chunk.m_ChunkSize < avail ? chunk.m_ChunkSize : avail;
+            if (pInfo->m_Format != WAV_FORMAT_IMA_ADPCM)
+                len -= len % pInfo->m_BlockAlign;
+            pInfo->m_DataOffset = offset;
+            pInfo->m_DataLen = len;
+            if (!WavNumFrames(pInfo))
+            {
+                s3eDebugTracePrintf("wav: empty data chunk");
+                return false;
+            }
+
+            // Keep walking: a smpl chunk is usually written after the data
+            gotData = true;
+        }
+
+        if (chunk.m_ChunkSize > avail)
+            break;
+
+        // Chunks are padded to an even length
+        offset += chunk.m_ChunkSize + (chunk.m_ChunkSize & 1);
+    }
+
+    if (!gotData)
+    {
+        s3eDebugTracePrintf("wav: no %s chunk", gotFormat ? "data" : "fmt");
+        return false;
+    }
+
+    CheckLoop(pInfo);
+    return true;
+}
+
+static bool MemoryRead(void* pCtx, uint32 offset, void* pDst, uint32 len)
+{
+    memcpy(pDst, (const uint8*)pCtx + offset, len);
+    return true;
+}
+
+bool WavParseMemory(const void* pData, uint32 len, WavInfo* pInfo)
+{
+    // WavParse never reads beyond len so no bounds checks are needed here
+    return WavParse(MemoryRead, (void*)pData, len, pInfo);
+}
+
+static bool FileRead(void* pCtx, uint32 offset, void* pDst, uint32 len)
+{
+    FILE* f = (FILE*)pCtx;
+    return fseek(f, offset, SEEK_SET) == 0 && fread(pDst, 1, len, f) == len;
+}
+
+bool WavGetInfo(const char* filename, WavInfo* pInfo)
+{
+    FILE* f = fopen(filename, "rb");
+    if (!f)
+        return false;
+
+    fseek(f, 0, SEEK_END);
+    int size = ftell(f);
+    bool ok = size > 0 && WavParse(FileRead, f, (uint32)size, pInfo);
+    fclose(f);
+    return ok;
+}
+
+//-----------------------------------------------------------------------------
+// Conversion
+//-----------------------------------------------------------------------------
+uint32 WavNumFrames(const WavInfo* pInfo)
+{
+    if (pInfo->m_Format != WAV_FORMAT_IMA_ADPCM)
+        return pInfo->m_DataLen / pInfo->m_BlockAlign;
+
+    uint32 blocks = pInfo->m_DataLen / pInfo->m_BlockAlign;
+    uint32 rest = pInfo->m_DataLen % pInfo->m_BlockAlign;
+    return blocks * pInfo->m_FramesPerBlock + AdpcmBlockFrames(rest, pInfo->m_NumChannels);
+}
+
+bool WavIsNative(const WavInfo* pInfo)
+{
+    return pInfo->m_Format == WAV_FORMAT_PCM && pInfo->m_BitsPerSample == 16 && pInfo->m_NumChannels == 1;
+}
+
+void WavConvertFrames(const WavInfo* pInfo, const void* pSrc, int16* pDst, int frames)
+{
+    // Source data is staged through an aligned buffer since mapped data
+    // chunks need not start on a 4 byte boundary
+    int32 raw[WAV_CONVERT_BLOCK * WAV_MAX_CHANNELS];
+    int16 interleaved[WAV_CONVERT_BLOCK * WAV_MAX_CHANNELS];
+
+    const uint8* pIn = (const uint8*)pSrc;
+    const int channels = pInfo->m_NumChannels;
+
+    while (frames > 0)
+    {
+        int n = frames < WAV_CONVERT_BLOCK ? frames : WAV_CONVERT_BLOCK;
+        int count = n * channels;
+        int16* pOut = channels == 1 ? pDst : interleaved;
+
+        memcpy(raw, pIn, n * pInfo->m_BlockAlign);
+
+        if (pInfo->m_Format == WAV_FORMAT_FLOAT)
+            SampleConvertF32((const float*)raw, pOut, count);
+        else switch (pInfo->m_BitsPerSample)
+        {
+        case 8:
+            SampleConvertU8((const uint8*)raw, pOut, count);
+            break;
+        case 16:
+            memcpy(pOut, raw, count * sizeof(int16));
+            break;
+        case 24:
+            SampleConvertS24((const uint8*)raw, pOut, count);
+            break;
+        default:
+            SampleConvertS32(raw, pOut, count);
+            break;
+        }
+
+        if (channels != 1)
+            SampleDownmix(interleaved, pDst, n, channels);
+
+        pIn += n * pInfo->m_BlockAlign;
+        pDst += n;
+        frames -= n;
+    }
+}
+
+//-----------------------------------------------------------------------------
+// Loading
+//-----------------------------------------------------------------------------
+static void SetLoop(const WavInfo* pInfo, SoundSample* pSample)
+{
+    pSample->m_LoopStart = pInfo->m_LoopStart;
+    pSample->m_LoopEnd = pInfo->m_LoopEnd;
+}
+
+static bool AllocNative(const WavInfo* pInfo, SoundSample* pSample)
+{
+    int frames = WavNumFrames(pInfo);
+    pSample->m_Data = (int16*)malloc(frames * sizeof(int16));
+    if (!pSample->m_Data)
+        return false;
+
+    pSample->m_DataLen = frames * sizeof(int16);
+    pSample->m_SampleRate = pInfo->m_SampleRate;
+    pSample->m_Storage = SOUNDSAMPLE_STORAGE_HEAP;
+    SetLoop(pInfo, pSample);
+    return true;
+}
+
+// Point @a pSample at IMA-ADPCM data, which stays compressed
+static void SetEncoded(const WavInfo* pInfo, const uint8* pData, SoundSampleStorage storage, SoundSample* pSample)
+{
+    pSample->m_Codec = SOUNDSAMPLE_CODEC_IMA_ADPCM;
+    pSample->m_pEncoded = pData;
+    pSample->m_EncodedLen = pInfo->m_DataLen;
+    pSample->m_BlockAlign = pInfo->m_BlockAlign;
+    pSample->m_NumChannels = pInfo->m_NumChannels;
+    pSample->m_FramesPerBlock = pInfo->m_FramesPerBlock;
+    pSample->m_DataLen = WavNativeLen(pInfo);
+    pSample->m_SampleRate = pInfo->m_SampleRate;
+    pSample->m_Storage = storage;
+    SetLoop(pInfo, pSample);
+}
+
+// A header parsed earlier only needs to still fit in the file
+static bool CheckKnown(const WavInfo* pKnown, uint32 size)
+{
+    return pKnown->m_DataOffset <= size && pKnown->m_DataLen <= size - pKnown->m_DataOffset;
+}
+
+static bool LoadCopy(const char* filename, const WavInfo* pKnown, SoundSample* pSample)
+{
+    FILE* f = fopen(filename, "rb");
+    if (!f)
+        return false;
+
+    fseek(f, 0, SEEK_END);
+    int size = ftell(f);
+    s3eDebugTracePrintf("filesize = %d", size);
+
+    WavInfo info;
+    bool valid;
+    if (pKnown)
+    {
+        info = *pKnown;
+        valid = size > 0 && CheckKnown(&info, (uint32)size);
+    }
+    else
+    {
+        valid = size > 0 && WavParse(FileRead, f, (uint32)size, &info);
+    }
+
+    if (!valid)
+    {
+        fclose(f);
+        return false;
+    }
+
+    fseek(f, info.m_DataOffset, SEEK_SET);
+
+    if (info.m_Format == WAV_FORMAT_IMA_ADPCM)
+    {
+        uint8* pEncoded = (uint8*)malloc(info.m_DataLen);
+        bool ok = pEncoded && fread(pEncoded, 1, info.m_DataLen, f) == info.m_DataLen;
+        fclose(f);
+        if (!ok)
+        {
+            free(pEncoded);
+            return false;
+        }
+        SetEncoded(&info, pEncoded, SOUNDSAMPLE_STORAGE_HEAP, pSample);
+        return true;
+    }
+
+    if (!AllocNative(&info, pSample))
+    {
+        fclose(f);
+        return false;
+    }
+
+    bool ok;
+    if (WavIsNative(&info))
+    {
+        ok = fread(pSample->m_Data, 1, info.m_DataLen, f) == info.m_DataLen;
+    }
+    else
+    {
+        // Convert a block at a time so the raw data is never resident at once
+        uint8* pBlock = (uint8*)malloc(WAV_READ_BLOCK);
+        int blockFrames = WAV_READ_BLOCK / info.m_BlockAlign;
+        int frames = WavNumFrames(&info);
+        int16* pDst = pSample->m_Data;
+
+        ok = pBlock != NULL;
+        while (ok && frames > 0)
+        {
+            int n = frames < blockFrames ? frames : blockFrames;
+            ok = fread(pBlock, info.m_BlockAlign, n, f) == (size_t)n;
+            if (ok)
+                WavConvertFrames(&info, pBlock, pDst, n);
+            pDst += n;
+            frames -= n;
+        }
+        free(pBlock);
+    }
+
+    fclose(f);
+
+    if (!ok)
+        SoundSampleRelease(pSample);
+    return ok;
+}
+
+static bool LoadMapped(const char* filename, const WavInfo* pKnown, SoundSample* pSample)
+{
+    int size;
+    void* base = SoundSampleMapFile(filename, &size);
+    if (!base)
+        return false;
+
+    WavInfo info;
+    if (pKnown)
+        info = *pKnown;
+    if (pKnown ? !CheckKnown(&info, size) : !WavParseMemory(base, size, &info))
+    {
+        SoundSampleUnmapFile(base, size);
+        return false;
+    }
+
+    const uint8* pData = (const uint8*)base + info.m_DataOffset;
+
+    if (info.m_Format == WAV_FORMAT_IMA_ADPCM)
+    {
+        // Compressed blocks are decoded straight out of the mapping
+        SetEncoded(&info, pData, SOUNDSAMPLE_STORAGE_MAPPED, pSample);
+        pSample->m_MapBase = base;
+        pSample->m_MapLen = size;
+        return true;
+    }
+
+    if (WavIsNative(&info))
+    {
+        // Play straight out of the mapping; nothing is copied
+        pSample->m_Data = (int16*)pData;
+        pSample->m_DataLen = (int)info.m_DataLen;
+        pSample->m_SampleRate = info.m_SampleRate;
+        pSample->m_Storage = SOUNDSAMPLE_STORAGE_MAPPED;
+        pSample->m_MapBase = base;
+        pSample->m_MapLen = size;
+        SetLoop(&info, pSample);
+        return true;
+    }
+
+    // Anything else is converted once, here, and the file is unmapped
+    bool ok = AllocNative(&info, pSample);
+    if (ok)
+        WavConvertFrames(&info, pData, pSample->m_Data, WavNumFrames(&info));
+
+    SoundSampleUnmapFile(base, size);
+    return ok;
+}
+
+bool WavLoad(const char* filename, SoundSample* pSample, WavLoadMode mode, const WavInfo* pInfo)
+{
+    SoundSampleInit(pSample);
+
+    if (mode == WAV_LOAD_MAP && LoadMapped(filename, pInfo, pSample))
+        return true;
+
+    return LoadCopy(filename, pInfo, pSample);
+}
@@ -0,0 +1,153 @@
+/*
+ * This file is part of the Marmalade SDK Code Samples.
+ *
+ * Copyright (C) 2001-2011 Ideaworks3D Ltd.
+ * All Rights Reserved.
+ *
+ * This source code is intended only as a supplement to Ideaworks Labs
+ * Development Tools and/or on-line documentation.
+ *
+ * THIS CODE AND INFORMATION ARE PROVIDED "AS IS" WITHOUT WARRANTY OF ANY
+ * KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+ * PARTICULAR PURPOSE.
+ */
+// .wav file loading
+//-----------------------------------------------------------------------------
+
+#ifndef WAV_FILE_H
+#define WAV_FILE_H
+
+#include "s3eTypes.h"
+#include <memory.h>
+
+#include "SoundSample.h"
+
+// The header for the output wave file
+struct RiffHeader
+{
+    char m_ChunkID[4];
+    int32 m_ChunkSize;
+    char m_RIFFType[4];
+
+    RiffHeader()
+    {
+        memcpy(m_ChunkID, "RIFF", 4);
+        memcpy(m_RIFFType, "WAVE", 4);
+    }
+};
+
+struct Chunk
+{
+    char m_ChunkID[4];
+    uint32 m_ChunkSize;
+};
+
+struct FormatChunk
+{
+    Chunk  m_Chunk;
+    uint16 m_CompressionCode;
+    uint16 m_NumberOfChannels;
+    uint32 m_SampleRate;
+    uint32 m_BytesPerSecond;
+    uint16 m_BlockAlign;
+    uint16 m_SignificantBits;
+};
+
+// m_CompressionCode values understood by the parser
+#define WAV_FORMAT_PCM          0x0001
+#define WAV_FORMAT_FLOAT        0x0003
+#define WAV_FORMAT_IMA_ADPCM    0x0011
+#define WAV_FORMAT_EXTENSIBLE   0xFFFE
+
+#define WAV_MAX_CHANNELS        8
+
+/**
+ * Format and data location of a validated .wav file. Extensible files are
+ * reported with the format of their sub type.
+ */
+typedef struct WavInfo
+{
+    uint16 m_Format;            // WAV_FORMAT_PCM, WAV_FORMAT_FLOAT or WAV_FORMAT_IMA_ADPCM
+    uint16 m_NumChannels;
+    uint32 m_SampleRate;
+    uint16 m_BlockAlign;        // bytes per frame, or per block for ADPCM
+    uint16 m_BitsPerSample;
+    uint32 m_FramesPerBlock;    // frames per ADPCM block, 0 for PCM
+    uint32 m_DataOffset;        // file offset of the first byte of sample data
+    uint32 m_DataLen;           // bytes of sample data, whole frames only (PCM)
+    uint32 m_LoopStart;         // first frame of the smpl chunk's first loop
+    uint32 m_LoopEnd;           // frame after the loop, 0 if there is none
+} WavInfo;
+
+/**
+ * Reads @a len bytes at @a offset into @a pDst; returns false on a short read.
+ */
+typedef bool (*WavReadFn)(void* pCtx, uint32 offset, void* pDst, uint32 len);
+
+/**
+ * Walk the chunks of a RIFF/WAVE file of @a fileSize bytes and validate its
+ * header, format chunk and data chunk. The first loop of a smpl chunk, if
+ * there is one, is kept as the loop region. Never reads past @a fileSize.
+ * @return true if the file is a supported .wav file; @a pInfo is then filled in.
+ */
+bool WavParse(WavReadFn readFn, void* pCtx, uint32 fileSize, WavInfo* pInfo);
+
+/**
+ * WavParse() for a file image already in memory.
+ */
+bool WavParseMemory(const void* pData, uint32 len, WavInfo* pInfo);
+
+/**
+ * Open @a filename just long enough to parse and validate its header.
+ */
+bool WavGetInfo(const char* filename, WavInfo* pInfo);
+
+/**
+ * Number of frames in the file's data chunk.
+ */
+uint32 WavNumFrames(const WavInfo* pInfo);
+
+/**
+ * Bytes of 16 bit mono data the file's data chunk converts to.
+ */
+inline uint32 WavNativeLen(const WavInfo* pInfo)
+{
+    return WavNumFrames(pInfo) * sizeof(int16);
+}
+
+/**
+ * Returns true if the data is already in the engine's format (16 bit mono
+ * PCM) and can be played without conversion.
+ */
+bool WavIsNative(const WavInfo* pInfo);
+
+/**
+ * Convert @a frames frames of PCM or float source data described by @a pInfo
+ * to 16 bit mono. @a pSrc need not be aligned. ADPCM data is not converted
+ * here; it is kept compressed and decoded as it plays (see Adpcm.h).
+ */
+void WavConvertFrames(const WavInfo* pInfo, const void* pSrc, int16* pDst, int frames);
+
+typedef enum WavLoadMode
+{
+    WAV_LOAD_COPY = 0,      // read the data chunk into a heap buffer
+    WAV_LOAD_MAP,           // map the file and point at the data chunk in place
+} WavLoadMode;
+
+/**
+ * Load the data chunk of a .wav file into @a pSample, converting it to
+ * 16 bit mono if it is stored in any other supported format. IMA-ADPCM data
+ * is kept compressed in m_pEncoded. The file's loop region is copied over.
+ *
+ * Files that need converting are converted once here and always end up on
+ * the heap. WAV_LOAD_MAP falls back to WAV_LOAD_COPY where mapping is not supported
+ * or fails. Release the result with SoundSampleRelease().
+ *
+ * If @a pInfo is given it must come from an earlier parse of the same file
+ * (see AssetManifest.h) and the header is not parsed again.
+ * @return true on success.
+ */
+bool WavLoad(const char* filename, SoundSample* pSample, WavLoadMode mode, const WavInfo* pInfo = NULL);
+
+#endif /* !WAV_FILE_H */
@@ -19,6 +19,9 @@
 #include "s3eTypes.h"
 
 #define S3E_SOUNDPOOL_MAX_VOLUME  0x100
+#define S3E_SOUNDPOOL_RATE_NORMAL 0x10000
+#define S3E_SOUNDPOOL_PAN_LEFT    -0x100
+#define S3E_SOUNDPOOL_PAN_RIGHT   0x100
 
 enum s3eSoundPoolError
 {
@@ -26,6 +29,7 @@ enum s3eSoundPoolError
     S3E_SOUNDPOOL_ERR_PARAM         = 1,
     S3E_SOUNDPOOL_ERR_TOO_MANY      = 2,
     S3E_SOUNDPOOL_ERR_ALREADY_REG   = 3,
+    S3E_SOUNDPOOL_ERR_NOT_READY     = 4,
 };
 
 enum s3eSoundPoolCallback
@@ -41,6 +45,19 @@ enum s3eSoundPoolCallback
      */
     S3E_SOUNDPOOL_STOP_AUDIO        = 0,
 
+    /**
+     * A handler function registered for this callback will be called when a
+     * sample started with s3eSoundPoolSampleLoadAsync() has finished
+     * decoding, or has failed to. Only raised where
+     * @ref S3E_SOUNDPOOL_ASYNC_LOAD is 1.
+     *
+     * Any callback created to respond to this event should conform to the
+     * following:
+     *
+     * @param systemData This is a pointer to #s3eSoundPoolLoadCompleteInfo.
+     */
+    S3E_SOUNDPOOL_LOAD_COMPLETE     = 1,
+
     S3E_SOUNDPOOL_CALLBACK_MAX
 };
 
@@ -50,6 +67,51 @@ struct s3eSoundPoolEndSampleInfo
      * The ID of the sample that generated this callback.
      */
     int32    m_SampleId;
+
+    /**
+     * The stream that ended, as returned by s3eSoundPoolStreamPlay(). Tells
+     * apart concurrent plays of the same sample. Only present when
+     * @ref S3E_SOUNDPOOL_STREAMS is 1; the shipped library passes just
+     * m_SampleId, which is then also the ID of the stream.
+     */
+    int32    m_StreamId;
+};
+
+/**
+ * Layout of the data passed to s3eSoundPoolSampleLoadFromMemory().
+ */
+enum s3eSoundPoolSampleFormat
+{
+    /**
+     * A complete .wav file image, in any format s3eSoundPoolSampleLoad()
+     * accepts. The sample rate is taken from its header.
+     */
+    S3E_SOUNDPOOL_FORMAT_WAV        = 0,
+
+    /**
+     * Raw 16 bit mono PCM, native byte order, with no header.
+     */
+    S3E_SOUNDPOOL_FORMAT_PCM16      = 1,
+};
+
+/**
+ * Called when the extension has finished with a buffer it adopted from
+ * s3eSoundPoolSampleLoadFromMemory(), with the @e userData given there.
+ */
+typedef void (*s3eSoundPoolReleaseFn)(const void* pData, void* userData);
+
+struct s3eSoundPoolLoadCompleteInfo
+{
+    /**
+     * The ID returned by s3eSoundPoolSampleLoadAsync().
+     */
+    int32    m_SampleId;
+
+    /**
+     * S3E_RESULT_SUCCESS if the sample can now be played. A sample that
+     * failed to load should still be unloaded to free its ID.
+     */
+    s3eResult m_Status;
 };
 
 enum s3eSoundPoolProperty
@@ -59,6 +121,60 @@ enum s3eSoundPoolProperty
      * S3E_SOUNDPOOL_MAX_VOLUME) represents maximum volume.
      */
     S3E_SOUNDPOOL_VOLUME            = 0,
+
+    /*
+     * Output buffering and its stats, S3E_SOUNDPOOL_BUFFER_FRAMES to
+     * S3E_SOUNDPOOL_UNDERRUNS, are for extensions that output through a
+     * buffered stream of their own. The shipped library plays through the
+     * platform's media player and does not support them: getting any of
+     * them returns -1, and setting them fails.
+     */
+
+    /**
+     * [read, write] Frames per output buffer. Writing requests a size, which
+     * takes effect from the next sample loaded; reading returns the size
+     * the platform gave. 0 requests the platform default.
+     */
+    S3E_SOUNDPOOL_BUFFER_FRAMES     = 1,
+
+    /**
+     * [read, write] Number of output buffers queued, requested and read
+     * back as for @ref S3E_SOUNDPOOL_BUFFER_FRAMES.
+     */
+    S3E_SOUNDPOOL_BUFFER_COUNT      = 2,
+
+    /**
+     * [read] Estimated time in milliseconds from a sample being played to
+     * it being heard, from the achieved buffering.
+     */
+    S3E_SOUNDPOOL_LATENCY_MS        = 3,
+
+    /**
+     * [read] Number of times output has run dry since the extension was
+     * initialised.
+     */
+    S3E_SOUNDPOOL_UNDERRUNS         = 4,
+
+    /**
+     * [read] 1 if s3eSoundPoolSampleLoadAsync() decodes in the background.
+     * The shipped library does not report this property; it loads before
+     * returning.
+     */
+    S3E_SOUNDPOOL_ASYNC_LOAD        = 5,
+
+    /**
+     * [read] 1 if every s3eSoundPoolStreamPlay() starts a stream of its own.
+     * The shipped library does not report this property; it plays each
+     * sample on a single stream whose ID is the sample's ID, so a new play
+     * replaces the last.
+     */
+    S3E_SOUNDPOOL_STREAMS           = 6,
+
+    /**
+     * [read] 1 if s3eSoundPoolSampleLoadFromMemory() can load samples. The
+     * shipped library does not report this property, and cannot.
+     */
+    S3E_SOUNDPOOL_LOAD_FROM_MEMORY  = 7,
 };
 
 enum s3eSoundPoolSampleProperty
@@ -83,6 +199,24 @@ enum s3eSoundPoolSampleProperty
      * This is 1 if channel is paused, otherwise 0 (playing or stopped).
      */
     S3E_SOUNDPOOL_STREAM_PAUSED     = 2,
+
+    /**
+     * [read, write] Playback rate, in 16.16 fixed point format,
+     * @ref S3E_SOUNDPOOL_RATE_NORMAL(0x10000) plays the sample at its own
+     * pitch. Changes take effect while the sample plays, so one sample can
+     * be played back at many pitches without keeping a copy for each.
+     * The shipped library plays through Android's MediaPlayer, which
+     * cannot change rate: getting this returns -1 and setting it fails.
+     */
+    S3E_SOUNDPOOL_STREAM_RATE       = 3,
+
+    /**
+     * [read, write] Stereo position, from @ref S3E_SOUNDPOOL_PAN_LEFT(-0x100)
+     * to @ref S3E_SOUNDPOOL_PAN_RIGHT(0x100), 0 being centre. Has no
+     * effect when the device output is mono. The shipped library does not
+     * support this property: getting it returns -1 and setting it fails.
+     */
+    S3E_SOUNDPOOL_STREAM_PAN        = 4,
 };
 // \cond HIDDEN_DEFINES
 S3E_BEGIN_C_DECL
@@ -197,7 +331,9 @@ int32 s3eSoundPoolSampleLoad(const char* pPath);
 s3eResult s3eSoundPoolSampleUnload(int32 sampleId);
 
 /**
- * Play a previously loaded samlpe.
+ * Play a previously loaded samlpe. Fails with
+ * @ref S3E_SOUNDPOOL_ERR_NOT_READY if it is still loading. Repeats start
+ * @a loopfrom milliseconds into the sample.
  */
 s3eResult s3eSoundPoolSamplePlay(int32 sampleId, int32 repeat, int32 loopfrom);
 
@@ -226,6 +362,99 @@ int32 s3eSoundPoolSampleGetInt(int32 sampleId, s3eSoundPoolSampleProperty proper
  */
 s3eResult s3eSoundPoolSampleSetInt(int32 sampleId, s3eSoundPoolSampleProperty property, int32 value);
 
+/*
+ * The functions below are not exported by the shipped native library.
+ * s3eSoundPool_compat.cpp builds them from the calls above, as described
+ * for each.
+ */
+
+/**
+ * Play @a count previously loaded samples, such as the notes of a chord.
+ * @a repeats gives each sample's repeat count, or may be NULL to play each
+ * once. Every sample is tried even if an earlier one fails. The shipped
+ * library is called once per sample, so this saves the caller's loop but
+ * not the calls into the extension.
+ * @return S3E_RESULT_ERROR if any of the samples failed to play.
+ */
+s3eResult s3eSoundPoolSamplePlayBatch(const int32* sampleIds, const int32* repeats, int32 count);
+
+/**
+ * Stop, pause or resume @a count samples. As for
+ * s3eSoundPoolSamplePlayBatch(), every sample is tried, one call each.
+ */
+s3eResult s3eSoundPoolSampleStopBatch(const int32* sampleIds, int32 count);
+s3eResult s3eSoundPoolSamplePauseBatch(const int32* sampleIds, int32 count);
+s3eResult s3eSoundPoolSampleResumeBatch(const int32* sampleIds, int32 count);
+
+/**
+ * Set @a property of each of @a count samples to the matching entry of
+ * @a values, for example to change the volume of a group of samples
+ * together. One call per sample, as for s3eSoundPoolSamplePlayBatch().
+ */
+s3eResult s3eSoundPoolSampleSetIntBatch(const int32* sampleIds, s3eSoundPoolSampleProperty property, const int32* values, int32 count);
+
+/**
+ * Start loading a sound sample from @a pPath and return without waiting
+ * for it to be decoded, where @ref S3E_SOUNDPOOL_ASYNC_LOAD is 1.
+ * @ref S3E_SOUNDPOOL_LOAD_COMPLETE is then raised with the returned ID once
+ * it has been. Until then s3eSoundPoolSamplePlay() on the ID fails with
+ * @ref S3E_SOUNDPOOL_ERR_NOT_READY; unloading it cancels the load.
+ *
+ * With the shipped library this is s3eSoundPoolSampleLoad(): the sample is
+ * ready when this returns and no callback is raised.
+ * @return Identifier of sample or -1 if the load could not be started
+ */
+int32 s3eSoundPoolSampleLoadAsync(const char* pPath);
+
+/**
+ * Load a sound sample from @a bytes bytes at @a pData, laid out as given by
+ * @a format. @a sampleRate is the rate of S3E_SOUNDPOOL_FORMAT_PCM16 data
+ * and is ignored for S3E_SOUNDPOOL_FORMAT_WAV.
+ *
+ * With @a releaseFn NULL the data is copied and the buffer may be freed
+ * as soon as this returns. Otherwise the buffer is adopted and played in
+ * place where the platform allows: it must stay valid and unchanged until
+ * @a releaseFn is called with it and @a userData. That happens once the
+ * sample has been unloaded, before s3eSoundPoolSampleUnload() returns, or
+ * before this returns if the data had to be copied after all or the load
+ * failed.
+ *
+ * The shipped library cannot load from memory: it opens every path as an
+ * APK asset, so the data cannot be passed through a file written at run
+ * time either. With it this always returns -1, after calling @a releaseFn,
+ * and s3eSoundPoolGetError() is not set. Check
+ * @ref S3E_SOUNDPOOL_LOAD_FROM_MEMORY first and load by path otherwise.
+ * @return Identifier of sample or -1 on failure
+ */
+int32 s3eSoundPoolSampleLoadFromMemory(const void* pData, int32 bytes, s3eSoundPoolSampleFormat format,
+    int32 sampleRate, s3eSoundPoolReleaseFn releaseFn, void* userData);
+
+/**
+ * Play a previously loaded sample on a new stream, leaving any streams
+ * already playing it alone, where @ref S3E_SOUNDPOOL_STREAMS is 1.
+ * @a repeat and @a loopfrom are as for s3eSoundPoolSamplePlay().
+ *
+ * With the shipped library this is s3eSoundPoolSamplePlay(), and the
+ * stream's ID is the sample's; the stream calls below act on the sample.
+ * @return Identifier of the stream, until it ends, or -1 on failure
+ */
+int32 s3eSoundPoolStreamPlay(int32 sampleId, int32 repeat, int32 loopfrom);
+
+/**
+ * Stop, pause or resume one stream of a sample. Fails once the stream has
+ * ended.
+ */
+s3eResult s3eSoundPoolStreamStop(int32 streamId);
+s3eResult s3eSoundPoolStreamPause(int32 streamId);
+s3eResult s3eSoundPoolStreamResume(int32 streamId);
+
+/**
+ * Get or set a s3eSoundPoolSampleProperty value, such as volume, rate or
+ * status, for one stream of a sample.
+ */
+int32 s3eSoundPoolStreamGetInt(int32 streamId, s3eSoundPoolSampleProperty property);
+s3eResult s3eSoundPoolStreamSetInt(int32 streamId, s3eSoundPoolSampleProperty property, int32 value);
+
 S3E_END_C_DECL
 
 
@@ -0,0 +1,135 @@
+/*
+ * This file is part of the Marmalade SDK Code Samples.
+ *
+ * Copyright (C) 2001-2011 Ideaworks3D Ltd.
+ * All Rights Reserved.
+ *
+ * This source code is intended only as a supplement to Ideaworks Labs
+ * Development Tools and/or on-line documentation.
+ *
+ * THIS CODE AND INFORMATION ARE PROVIDED "AS IS" WITHOUT WARRANTY OF ANY
+ * KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+ * PARTICULAR PURPOSE.
+ */
+// s3eSoundPool calls the shipped native library does not export
+//-----------------------------------------------------------------------------
+//
+// Unlike s3eSoundPool_interface.cpp this file is not generated. The native
+// library registers only the 17 functions in that file's table, so the
+// calls below are built from those. Once a native build implements one of
+// them, declare it in the extension's .s4e, regenerate the interface and
+// remove it from here.
+
+#include "s3eSoundPool.h"
+
+//-----------------------------------------------------------------------------
+// Batches: one call into the extension per sample
+//-----------------------------------------------------------------------------
+s3eResult s3eSoundPoolSamplePlayBatch(const int32* sampleIds, const int32* repeats, int32 count)
+{
+    s3eResult result = S3E_RESULT_SUCCESS;
+    for (int32 i = 0; i < count; i++)
+    {
+        if (s3eSoundPoolSamplePlay(sampleIds[i], repeats ? repeats[i] : 1, 0))
+            result = S3E_RESULT_ERROR;
+    }
+    return result;
+}
+
+s3eResult s3eSoundPoolSampleStopBatch(const int32* sampleIds, int32 count)
+{
+    s3eResult result = S3E_RESULT_SUCCESS;
+    for (int32 i = 0; i < count; i++)
+    {
+        if (s3eSoundPoolSampleStop(sampleIds[i]))
+            result = S3E_RESULT_ERROR;
+    }
+    return result;
+}
+
+s3eResult s3eSoundPoolSamplePauseBatch(const int32* sampleIds, int32 count)
+{
+    s3eResult result = S3E_RESULT_SUCCESS;
+    for (int32 i = 0; i < count; i++)
+    {
+        if (s3eSoundPoolSamplePause(sampleIds[i]))
+            result = S3E_RESULT_ERROR;
+    }
+    return result;
+}
+
+s3eResult s3eSoundPoolSampleResumeBatch(const int32* sampleIds, int32 count)
+{
+    s3eResult result = S3E_RESULT_SUCCESS;
+    for (int32 i = 0; i < count; i++)
+    {
+        if (s3eSoundPoolSampleResume(sampleIds[i]))
+            result = S3E_RESULT_ERROR;
+    }
+    return result;
+}
+
+s3eResult s3eSoundPoolSampleSetIntBatch(const int32* sampleIds, s3eSoundPoolSampleProperty property, const int32* values, int32 count)
+{
+    s3eResult result = S3E_RESULT_SUCCESS;
+    for (int32 i = 0; i < count; i++)
+    {
+        if (s3eSoundPoolSampleSetInt(sampleIds[i], property, values[i]))
+            result = S3E_RESULT_ERROR;
+    }
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+// Loading
+//-----------------------------------------------------------------------------
+int32 s3eSoundPoolSampleLoadAsync(const char* pPath)
+{
+    // Loaded before returning, so the sample is ready as soon as it has an
+    // ID and S3E_SOUNDPOOL_LOAD_COMPLETE is never raised
+    return s3eSoundPoolSampleLoad(pPath);
+}
+
+int32 s3eSoundPoolSampleLoadFromMemory(const void* pData, int32 bytes, s3eSoundPoolSampleFormat format,
+    int32 sampleRate, s3eSoundPoolReleaseFn releaseFn, void* userData)
+{
+    // The native library opens every path it is given as an APK asset, so
+    // not even a file written out here could be loaded
+    if (releaseFn)
+        releaseFn(pData, userData);
+    return -1;
+}
+
+//-----------------------------------------------------------------------------
+// Streams: one per sample, with the sample's ID
+//-----------------------------------------------------------------------------
+int32 s3eSoundPoolStreamPlay(int32 sampleId, int32 repeat, int32 loopfrom)
+{
+    return s3eSoundPoolSamplePlay(sampleId, repeat, loopfrom) == S3E_RESULT_SUCCESS ? sampleId : -1;
+}
+
+s3eResult s3eSoundPoolStreamStop(int32 streamId)
+{
+    return s3eSoundPoolSampleStop(streamId);
+}
+
+s3eResult s3eSoundPoolStreamPause(int32 streamId)
+{
+    return s3eSoundPoolSamplePause(streamId);
+}
+
+s3eResult s3eSoundPoolStreamResume(int32 streamId)
+{
+    return s3eSoundPoolSampleResume(streamId);
+}
+
+int32 s3eSoundPoolStreamGetInt(int32 streamId, s3eSoundPoolSampleProperty property)
+{
+    return s3eSoundPoolSampleGetInt(streamId, property);
+}
+
+s3eResult s3eSoundPoolStreamSetInt(int32 streamId, s3eSoundPoolSampleProperty property, int32 value)
+{
+    return s3eSoundPoolSampleSetInt(streamId, property, value);
+}
@@ -53,12 +53,23 @@ typedef struct s3eSoundPoolFuncs
     s3eSoundPoolSampleSetInt_t m_s3eSoundPoolSampleSetInt;
 } s3eSoundPoolFuncs;
 
+/**
+ * Tracing every call looks up the trace channel each time, which adds up
+ * when samples are polled every frame, so it is only built in when
+ * S3E_SOUNDPOOL_TRACE_CALLS is defined.
+ */
+#ifdef S3E_SOUNDPOOL_TRACE_CALLS
+#define _extTraceCall(args) IwTrace(SOUNDPOOL_VERBOSE, args)
+#else
+#define _extTraceCall(args)
+#endif
+
 static s3eSoundPoolFuncs g_Ext;
 static bool g_GotExt = false;
 static bool g_TriedExt = false;
 static bool g_TriedNoMsgExt = false;
 
-static bool _extLoad()
+static bool _extLoadSlow()
 {
     if (!g_GotExt && !g_TriedExt)
     {
@@ -74,6 +85,15 @@ static bool _extLoad()
     return g_GotExt;
 }
 
+/**
+ * The table is resolved once, normally by s3eSoundPoolAvailable() at init;
+ * after that every call is a test of g_GotExt and a call through g_Ext.
+ */
+static inline bool _extLoad()
+{
+    return g_GotExt || _extLoadSlow();
+}
+
 static bool _extLoadNoMsg()
 {
     if (!g_GotExt && !g_TriedNoMsgExt)
@@ -97,7 +117,7 @@ s3eBool s3eSoundPoolAvailable()
 
 s3eResult s3eSoundPoolRegister(s3eSoundPoolCallback cbid, s3eCallback fn, void* userData)
 {
-    IwTrace(SOUNDPOOL_VERBOSE, ("calling s3eSoundPool[0] func: s3eSoundPoolRegister"));
+    _extTraceCall(("calling s3eSoundPool[0] func: s3eSoundPoolRegister"));
 
     if (!_extLoad())
         return S3E_RESULT_ERROR;
@@ -107,7 +127,7 @@ s3eResult s3eSoundPoolRegister(s3eSoundPoolCallback cbid, s3eCallback fn, void*
 
 s3eResult s3eSoundPoolUnRegister(s3eSoundPoolCallback cbid, s3eCallback fn)
 {
-    IwTrace(SOUNDPOOL_VERBOSE, ("calling s3eSoundPool[1] func: s3eSoundPoolUnRegister"));
+    _extTraceCall(("calling s3eSoundPool[1] func: s3eSoundPoolUnRegister"));
 
     if (!_extLoad())
         return S3E_RESULT_ERROR;
@@ -117,7 +137,7 @@ s3eResult s3eSoundPoolUnRegister(s3eSoundPoolCallback cbid, s3eCallback fn)
 
 const char* s3eSoundPoolGetErrorString()
 {
-    IwTrace(SOUNDPOOL_VERBOSE, ("calling s3eSoundPool[2] func: s3eSoundPoolGetErrorString"));
+    _extTraceCall(("calling s3eSoundPool[2] func: s3eSoundPoolGetErrorString"));
 
     if (!_extLoad())
         return NULL;
@@ -127,7 +147,7 @@ const char* s3eSoundPoolGetErrorString()
 
 s3eSoundPoolError s3eSoundPoolGetError()
 {
-    IwTrace(SOUNDPOOL_VERBOSE, ("calling s3eSoundPool[3] func: s3eSoundPoolGetError"));
+    _extTraceCall(("calling s3eSoundPool[3] func: s3eSoundPoolGetError"));
 
     if (!_extLoad())
         return (s3eSoundPoolError)0;
@@ -137,7 +157,7 @@ s3eSoundPoolError s3eSoundPoolGetError()
 
 int32 s3eSoundPoolGetInt(s3eSoundPoolProperty property)
 {
-    IwTrace(SOUNDPOOL_VERBOSE, ("calling s3eSoundPool[4] func: s3eSoundPoolGetInt"));
+    _extTraceCall(("calling s3eSoundPool[4] func: s3eSoundPoolGetInt"));
 
     if (!_extLoad())
         return -1;
@@ -147,7 +167,7 @@ int32 s3eSoundPoolGetInt(s3eSoundPoolProperty property)
 
 s3eResult s3eSoundPoolSetInt(s3eSoundPoolProperty property, int32 value)
 {
-    IwTrace(SOUNDPOOL_VERBOSE, ("calling s3eSoundPool[5] func: s3eSoundPoolSetInt"));
+    _extTraceCall(("calling s3eSoundPool[5] func: s3eSoundPoolSetInt"));
 
     if (!_extLoad())
         return S3E_RESULT_ERROR;
@@ -157,7 +177,7 @@ s3eResult s3eSoundPoolSetInt(s3eSoundPoolProperty property, int32 value)
 
 s3eResult s3eSoundPoolPauseAllSamples()
 {
-    IwTrace(SOUNDPOOL_VERBOSE, ("calling s3eSoundPool[6] func: s3eSoundPoolPauseAllSamples"));
+    _extTraceCall(("calling s3eSoundPool[6] func: s3eSoundPoolPauseAllSamples"));
 
     if (!_extLoad())
         return S3E_RESULT_ERROR;
@@ -167,7 +187,7 @@ s3eResult s3eSoundPoolPauseAllSamples()
 
 s3eResult s3eSoundPoolResumeAllSamples()
 {
-    IwTrace(SOUNDPOOL_VERBOSE, ("calling s3eSoundPool[7] func: s3eSoundPoolResumeAllSamples"));
+    _extTraceCall(("calling s3eSoundPool[7] func: s3eSoundPoolResumeAllSamples"));
 
     if (!_extLoad())
         return S3E_RESULT_ERROR;
@@ -177,7 +197,7 @@ s3eResult s3eSoundPoolResumeAllSamples()
 
 s3eResult s3eSoundPoolStopAllSamples()
 {
-    IwTrace(SOUNDPOOL_VERBOSE, ("calling s3eSoundPool[8] func: s3eSoundPoolStopAllSamples"));
+    _extTraceCall(("calling s3eSoundPool[8] func: s3eSoundPoolStopAllSamples"));
 
     if (!_extLoad())
         return S3E_RESULT_ERROR;
@@ -187,7 +207,7 @@ s3eResult s3eSoundPoolStopAllSamples()
 
 int32 s3eSoundPoolSampleLoad(const char* pPath)
 {
-    IwTrace(SOUNDPOOL_VERBOSE, ("calling s3eSoundPool[9] func: s3eSoundPoolSampleLoad"));
+    _extTraceCall(("calling s3eSoundPool[9] func: s3eSoundPoolSampleLoad"));
 
     if (!_extLoad())
         return -1;
@@ -197,7 +217,7 @@ int32 s3eSoundPoolSampleLoad(const char* pPath)
 
 s3eResult s3eSoundPoolSampleUnload(int32 sampleId)
 {
-    IwTrace(SOUNDPOOL_VERBOSE, ("calling s3eSoundPool[10] func: s3eSoundPoolSampleUnload"));
+    _extTraceCall(("calling s3eSoundPool[10] func: s3eSoundPoolSampleUnload"));
 
     if (!_extLoad())
         return S3E_RESULT_ERROR;
@@ -207,7 +227,7 @@ s3eResult s3eSoundPoolSampleUnload(int32 sampleId)
 
 s3eResult s3eSoundPoolSamplePlay(int32 sampleId, int32 repeat, int32 loopfrom)
 {
-    IwTrace(SOUNDPOOL_VERBOSE, ("calling s3eSoundPool[11] func: s3eSoundPoolSamplePlay"));
+    _extTraceCall(("calling s3eSoundPool[11] func: s3eSoundPoolSamplePlay"));
 
     if (!_extLoad())
         return S3E_RESULT_ERROR;
@@ -217,7 +237,7 @@ s3eResult s3eSoundPoolSamplePlay(int32 sampleId, int32 repeat, int32 loopfrom)
 
 s3eResult s3eSoundPoolSampleStop(int32 sampleId)
 {
-    IwTrace(SOUNDPOOL_VERBOSE, ("calling s3eSoundPool[12] func: s3eSoundPoolSampleStop"));
+    _extTraceCall(("calling s3eSoundPool[12] func: s3eSoundPoolSampleStop"));
 
     if (!_extLoad())
         return S3E_RESULT_ERROR;
@@ -227,7 +247,7 @@ s3eResult s3eSoundPoolSampleStop(int32 sampleId)
 
 s3eResult s3eSoundPoolSamplePause(int32 sampleId)
 {
-    IwTrace(SOUNDPOOL_VERBOSE, ("calling s3eSoundPool[13] func: s3eSoundPoolSamplePause"));
+    _extTraceCall(("calling s3eSoundPool[13] func: s3eSoundPoolSamplePause"));
 
     if (!_extLoad())
         return S3E_RESULT_ERROR;
@@ -237,7 +257,7 @@ s3eResult s3eSoundPoolSamplePause(int32 sampleId)
 
 s3eResult s3eSoundPoolSampleResume(int32 sampleId)
 {
-    IwTrace(SOUNDPOOL_VERBOSE, ("calling s3eSoundPool[14] func: s3eSoundPoolSampleResume"));
+    _extTraceCall(("calling s3eSoundPool[14] func: s3eSoundPoolSampleResume"));
 
     if (!_extLoad())
         return S3E_RESULT_ERROR;
@@ -247,7 +267,7 @@ s3eResult s3eSoundPoolSampleResume(int32 sampleId)
 
 int32 s3eSoundPoolSampleGetInt(int32 sampleId, s3eSoundPoolSampleProperty property)
 {
-    IwTrace(SOUNDPOOL_VERBOSE, ("calling s3eSoundPool[15] func: s3eSoundPoolSampleGetInt"));
+    _extTraceCall(("calling s3eSoundPool[15] func: s3eSoundPoolSampleGetInt"));
 
     if (!_extLoad())
         return -1;
@@ -257,7 +277,7 @@ int32 s3eSoundPoolSampleGetInt(int32 sampleId, s3eSoundPoolSampleProperty proper
 
 s3eResult s3eSoundPoolSampleSetInt(int32 sampleId, s3eSoundPoolSampleProperty property, int32 value)
 {
-    IwTrace(SOUNDPOOL_VERBOSE, ("calling s3eSoundPool[16] func: s3eSoundPoolSampleSetInt"));
+    _extTraceCall(("calling s3eSoundPool[16] func: s3eSoundPoolSampleSetInt"));
 
     if (!_extLoad())
         return S3E_RESULT_ERROR;
@@ -19,102 +19,110 @@
  */
 #include "ExamplesMain.h"
 #include <stdio.h>
-#include <dirent.h>
 #include <malloc.h>
 #include <memory.h>
+#include <stdlib.h>
 
 #include "s3eSound.h"
 #include "s3eSoundPool.h"
+#include "s3eConfig.h"
 
 #include "IwGx.h"
 
-// The header for the output wave file
-struct RiffHeader
-{
-    char m_ChunkID[4];
-    int32 m_ChunkSize;
-    char m_RIFFType[4];
-
-    RiffHeader()
-    {
-        memcpy(m_ChunkID, "RIFF", 4);
-        memcpy(m_RIFFType, "WAVE", 4);
-    }
-};
-
-struct Chunk
-{
-    char m_ChunkID[4];
-    uint32 m_ChunkSize;
-};
-
-struct FormatChunk
-{
-    Chunk  m_Chunk;
-    uint16 m_CompressionCode;
-    uint16 m_NumberOfChannels;
-    uint32 m_SampleRate;
-    uint32 m_BytesPerSecond;
-    uint16 m_BlockAlign;
-    uint16 m_SignificantBits;
-};
+#include "WavFile.h"
+#include "SampleLoader.h"
+#include "SampleStream.h"
+#include "SoundMixer.h"
+#include "MasterEffects.h"
+#include "SoundBench.h"
+#include "SoundBank.h"
+#include "SampleCache.h"
+#include "AssetManifest.h"
+#include "SoundQueue.h"
+#include "Resampler.h"
 
 static bool g_UseSoundPool = true;
 
 #define MAX_SAMPLES 9
 
 static const char* g_Buttons[MAX_SAMPLES];
-static int16* g_SampleData[MAX_SAMPLES];
-static int g_SampleDataLen[MAX_SAMPLES];
+static const char* g_Paths[MAX_SAMPLES];
+static AssetManifestEntry g_Assets[MAX_SAMPLES];
+static SoundSample g_SampleData[MAX_SAMPLES];
 static int g_Samples[MAX_SAMPLES];
+static int g_Voices[MAX_SAMPLES];      // latest mixer voice or pool stream of each pad
 static int g_SampleState[MAX_SAMPLES];
+static WavLoadMode g_WavLoadMode = WAV_LOAD_MAP;
+static int g_StreamThreshold = 0x100000;
+static SoundBank* g_Bank = NULL;
+static int g_CacheBudget = 0;
+static int g_SampleBytes[MAX_SAMPLES];
+static bool g_ResampleOnLoad = false;
+static ResamplerQuality g_Resampling = RESAMPLER_SINC;
+static int g_PitchVariation = 0;
+static int g_FadeFrames = 0;
+static int g_PanSpread = 0;
+static int g_OutputBufferFrames = 0;
+static int g_OutputBuffers = 0;
+static uint32 g_QuantizeFrames = 0;
+
+// Samples the sound pool has reported ended, from its own thread, and
+// whether the reports name the stream. Every pad's latest stream can end
+// between two updates, with room to spare for the earlier hits of pads
+// that layer them. Reports that still do not fit are counted.
+#define MAX_ENDED_STREAMS 64
+static SoundQueue g_EndedSamples;
+static bool g_PoolStreams = false;
+static volatile uint32 g_EndedDropped = 0;
+static uint32 g_EndedDroppedSeen = 0;
+
+// Samples the sound pool has finished loading in the background, and the
+// pads' load state when it is loading them rather than the SampleLoader
+// Every pad's load can complete before the first update, so the queue holds
+// one report per pad, rounded up to the power of two SoundQueue needs
+#define MAX_LOADED_SAMPLES 16
+#if MAX_LOADED_SAMPLES < MAX_SAMPLES
+#error the load queue must hold a report for every pad
+#endif
+static SoundQueue g_LoadedSamples;
+static bool g_AsyncLoad = false;
+static SampleLoadState g_PoolLoadState[MAX_SAMPLES];
 
-int16* LoadWav(const char* filename, int* sizeOut)
+int32 SampleEnded(s3eSoundPoolEndSampleInfo* pInfo, void* userData)
 {
-    RiffHeader header;
-    Chunk chunk;
-
-    int16* rtn = NULL;
-    FILE* f = fopen(filename, "r");
-    fseek(f, 0, SEEK_END);
-    int size = ftell(f);
-    s3eDebugTracePrintf("filesize = %d", size);
-    fseek(f, 0, SEEK_SET);
-    fread(&header, 1, sizeof(header), f);
-    s3eDebugTracePrintf("%d %.4s %.4s %u", sizeof(header), header.m_ChunkID, header.m_RIFFType, header.m_ChunkSize);
-
-    while (1)
-    {
-        fread(&chunk, 1, sizeof(chunk), f);
-        if (!strncmp(chunk.m_ChunkID, "data", 4))
-        {
-            rtn = (int16*)malloc(chunk.m_ChunkSize);
-            fread(rtn, 1, chunk.m_ChunkSize, f);
-            *sizeOut = chunk.m_ChunkSize;
-            break;
-        }
-        fseek(f, chunk.m_ChunkSize, SEEK_CUR);
-    }
+    // Extensions without streams pass only the sample, which is also the
+    // stream's ID
+    s3eSoundPoolEndSampleInfo info;
+    info.m_SampleId = pInfo->m_SampleId;
+    info.m_StreamId = g_PoolStreams ? pInfo->m_StreamId : pInfo->m_SampleId;
+
+    // The pad state is only touched in ExampleUpdate()
+    if (!SoundQueuePush(&g_EndedSamples, &info))
+        g_EndedDropped++;
 
-    fclose(f);
-    return rtn;
+    return 1;
 }
 
-int32 SampleEnded(s3eSoundPoolEndSampleInfo* pInfo, void* userData)
+int32 SampleLoaded(s3eSoundPoolLoadCompleteInfo* pInfo, void* userData)
 {
-    s3eDebugTracePrintf("sample ended = %d", pInfo->m_SampleId);
-
-    g_SampleState[pInfo->m_SampleId] = 0;
+    SoundQueuePush(&g_LoadedSamples, pInfo);
 
     return 1;
 }
 
-int32 ChannelEnded(s3eSoundEndSampleInfo* pInfo, void* userData)
+SampleLoadState LoadState(int i)
 {
-    s3eDebugTracePrintf("channel ended = %d", pInfo->m_Channel);
-    
-    g_SampleState[pInfo->m_Channel] = 0;
-    
+    return g_AsyncLoad ? g_PoolLoadState[i] : SampleLoaderGetState(i);
+}
+
+int32 VoiceEnded(SoundMixerEndInfo* pInfo, void* userData)
+{
+    s3eDebugTracePrintf("voice ended = %d (sample %d)", pInfo->m_Voice, pInfo->m_UserId);
+
+    // Only the pad's latest hit drives its state
+    if (g_Voices[pInfo->m_UserId] == pInfo->m_Voice)
+        g_SampleState[pInfo->m_UserId] = 0;
+
     return 1;
 }
 
@@ -122,92 +130,448 @@ void RegisterCallbacks()
 {
     if (g_UseSoundPool)
     {
+        // Applies to the samples loaded from here on
+        if ((g_OutputBufferFrames && s3eSoundPoolSetInt(S3E_SOUNDPOOL_BUFFER_FRAMES, g_OutputBufferFrames)) ||
+            (g_OutputBuffers && s3eSoundPoolSetInt(S3E_SOUNDPOOL_BUFFER_COUNT, g_OutputBuffers)))
+            s3eDebugTracePrintf("sound pool: output buffering cannot be set on this extension");
+
+        g_PoolStreams = s3eSoundPoolGetInt(S3E_SOUNDPOOL_STREAMS) == 1;
+        SoundQueueInit(&g_EndedSamples, sizeof(s3eSoundPoolEndSampleInfo), MAX_ENDED_STREAMS);
         s3eSoundPoolRegister(S3E_SOUNDPOOL_STOP_AUDIO, (s3eCallback)SampleEnded, 0);
     }
     else
     {
-        for (int i=0; i<MAX_SAMPLES; ++i)
-        {
-            s3eSoundChannelRegister(i, S3E_CHANNEL_STOP_AUDIO, (s3eCallback)ChannelEnded, 0);
-        }
+        // Every pad is mixed into one channel
+        int maxVoices = 16;
+        char policy[S3E_CONFIG_STRING_MAX] = "oldest";
+        s3eConfigGetInt("SoundBoard", "MaxVoices", &maxVoices);
+        s3eConfigGetString("SoundBoard", "StealPolicy", policy);
+
+        SoundMixerStealPolicy steal = SOUNDMIXER_STEAL_OLDEST;
+        if (!stricmp(policy, "none"))
+            steal = SOUNDMIXER_STEAL_NONE;
+        else if (!stricmp(policy, "quietest"))
+            steal = SOUNDMIXER_STEAL_QUIETEST;
+        else if (!stricmp(policy, "priority"))
+            steal = SOUNDMIXER_STEAL_PRIORITY;
+
+        SoundMixerSetPolyphony(maxVoices, steal);
+        int rampFrames = SOUNDMIXER_RAMP_FRAMES;
+        s3eConfigGetInt("SoundBoard", "RampFrames", &rampFrames);
+        s3eConfigGetInt("SoundBoard", "FadeFrames", &g_FadeFrames);
+        SoundMixerSetRampFrames(rampFrames);
+        SoundMixerSetResampling(g_Resampling);
+        if (g_OutputBuffers)
+            SoundMixerSetOutputBuffers(g_OutputBuffers);
+        SoundMixerInit(0, VoiceEnded, 0);
+
+        int quantizeMs = 0;
+        s3eConfigGetInt("SoundBoard", "QuantizeMs", &quantizeMs);
+        if (quantizeMs > 0)
+            g_QuantizeFrames = (uint32)((int64)quantizeMs * SoundMixerGetOutputRate() / 1000);
+
+        // By default only the limiter is in, to stop pads that are hit
+        // together clipping
+        char effects[S3E_CONFIG_STRING_MAX] = "limiter";
+        s3eConfigGetString("SoundBoard", "MasterEffects", effects);
+        MasterEffectsSetBypass(MASTEREFFECT_COMPRESSOR, !strstr(effects, "compressor"));
+        MasterEffectsSetBypass(MASTEREFFECT_REVERB, !strstr(effects, "reverb"));
+        MasterEffectsSetBypass(MASTEREFFECT_LIMITER, !strstr(effects, "limiter"));
     }
 }
 
-void Load(int i, const char* pPath)
+// Trade memory for CPU: convert in-memory PCM to the output rate once,
+// rather than every time it plays. Compressed and streamed samples are
+// always converted as they play.
+void ConvertRate(int i)
 {
+    if (!g_ResampleOnLoad)
+        return;
+
+    uint32 rate = g_SampleData[i].m_SampleRate;
+    if (ResamplerConvertSample(&g_SampleData[i], SoundMixerGetOutputRate(), g_Resampling) &&
+        rate != g_SampleData[i].m_SampleRate)
+        s3eDebugTracePrintf("resampled sound %d: %u Hz to %u Hz", i, rate, g_SampleData[i].m_SampleRate);
+}
+
+bool LoadSample(int i, const char* pPath)
+{
+    bool ok;
     if (g_UseSoundPool)
+    {
         g_Samples[i] = s3eSoundPoolSampleLoad(pPath);
+        ok = g_Samples[i] != -1;
+    }
     else
-        g_SampleData[i] = LoadWav(pPath, &g_SampleDataLen[i]);
+    {
+        // Headers were parsed, or taken from the manifest, by the scan.
+        // Long samples are left on disk and streamed when played. ADPCM
+        // samples are small enough resident that they are always loaded.
+        const WavInfo* pInfo = &g_Assets[i].m_Info;
+        if (!g_Assets[i].m_Valid)
+            ok = false;
+        else if (g_StreamThreshold > 0 && pInfo->m_Format != WAV_FORMAT_IMA_ADPCM &&
+            WavNativeLen(pInfo) > (uint32)g_StreamThreshold)
+            ok = SampleStreamOpen(pPath, pInfo, &g_SampleData[i]);
+        else
+            ok = WavLoad(pPath, &g_SampleData[i], g_WavLoadMode, pInfo);
+    }
+
+    if (ok)
+        ConvertRate(i);
+
+    s3eDebugTracePrintf("loaded sound %d: %s (%d)", i, ok ? "ok" : "failed", g_SampleData[i].m_DataLen);
+    return ok;
 }
 
-s3eResult Play(int i, int repeat)
+// Runs on a SampleLoader worker thread
+bool Load(int i, const char* pPath)
+{
+    if (!g_CacheBudget)
+        return LoadSample(i, pPath);
+
+    // With a cache, samples are only loaded when first triggered. The
+    // header tells the cache how much room to make for it.
+    const WavInfo* pInfo = &g_Assets[i].m_Info;
+    if (!g_Assets[i].m_Valid)
+        return false;
+
+    g_SampleBytes[i] = pInfo->m_Format == WAV_FORMAT_IMA_ADPCM ? pInfo->m_DataLen : WavNativeLen(pInfo);
+    SampleCacheSetSizeHint(i, g_SampleBytes[i]);
+    return true;
+}
+
+int CacheLoad(int i)
+{
+    if (!LoadSample(i, g_Paths[i]))
+        return -1;
+
+    // The extension does not report what a sample costs it, so assume
+    // the size of its 16 bit data
+    return g_UseSoundPool ? g_SampleBytes[i] : SoundSampleResidentBytes(&g_SampleData[i]);
+}
+
+void CacheUnload(int i)
 {
     if (g_UseSoundPool)
-        return s3eSoundPoolSamplePlay(g_Samples[i], repeat, 0);
+    {
+        s3eSoundPoolSampleUnload(g_Samples[i]);
+        g_Samples[i] = -1;
+    }
     else
-        return s3eSoundChannelPlay(i, g_SampleData[i], g_SampleDataLen[i]/2, repeat, 0);
+    {
+        SoundSampleRelease(&g_SampleData[i]);
+    }
+}
+
+bool CacheBusy(int i)
+{
+    // Earlier hits of a pad may still be sounding after its state is reset
+    return g_SampleState[i] != 0 || (!g_UseSoundPool && SoundMixerIsPlaying(&g_SampleData[i]));
+}
+
+void BankDataReleased(const void* pData, void* userData)
+{
+    // The bank owns the data, and outlives the samples made from it
+}
+
+// Pads map one to one onto bank entries, which are used in place
+bool LoadFromBank(int i, const char* pName)
+{
+    if (!SoundBankGetSample(g_Bank, i, &g_SampleData[i]))
+        return false;
+
+    if (g_UseSoundPool)
+    {
+        // The extension is handed the entry's data to adopt rather than a
+        // file to read it back from. It only takes PCM.
+        const SoundSample* s = &g_SampleData[i];
+        if (s->m_Codec != SOUNDSAMPLE_CODEC_PCM)
+            return false;
+
+        g_Samples[i] = s3eSoundPoolSampleLoadFromMemory(s->m_Data, s->m_DataLen, S3E_SOUNDPOOL_FORMAT_PCM16,
+            s->m_SampleRate, BankDataReleased, NULL);
+        return g_Samples[i] != -1;
+    }
+
+    ConvertRate(i);
+    return true;
+}
+
+s3eResult Play(int i, int repeat)
+{
+    if (g_CacheBudget && !SampleCacheAcquire(i))
+        return S3E_RESULT_ERROR;
+
+    // Each hit is detuned a little, rather than playing one of several
+    // pre-pitched copies of the sample
+    int32 rate = S3E_SOUNDPOOL_RATE_NORMAL;
+    if (g_PitchVariation)
+        rate += (int32)((int64)S3E_SOUNDPOOL_RATE_NORMAL * (rand() % (2 * g_PitchVariation + 1) - g_PitchVariation) / 100);
+
+    // Pads are laid out across the stereo field, first on the left
+    int pan = g_PanSpread * (2 * i - (MAX_SAMPLES - 1)) / (MAX_SAMPLES - 1);
+
+    if (g_UseSoundPool)
+    {
+        // The pool only takes a loop start, in milliseconds rather than
+        // frames; repeats run on to the end of the sample. The mixer also
+        // honours the loop end.
+        uint32 loopStart = 0;
+        uint32 sampleRate = 0;
+        if (g_Bank)
+        {
+            loopStart = g_SampleData[i].m_LoopStart;
+            sampleRate = g_SampleData[i].m_SampleRate;
+        }
+        else if (g_Assets[i].m_Valid)
+        {
+            loopStart = g_Assets[i].m_Info.m_LoopStart;
+            sampleRate = g_Assets[i].m_Info.m_SampleRate;
+        }
+        int32 loopfrom = sampleRate ? (int32)((uint64)loopStart * 1000 / sampleRate) : 0;
+        int32 stream = s3eSoundPoolStreamPlay(g_Samples[i], repeat, loopfrom);
+        if (stream == -1)
+            return S3E_RESULT_ERROR;
+
+        // Not every extension can change pitch; the hit still plays
+        if (rate != S3E_SOUNDPOOL_RATE_NORMAL && s3eSoundPoolStreamSetInt(stream, S3E_SOUNDPOOL_STREAM_RATE, rate))
+            s3eDebugTracePrintf("sound pool: cannot set the rate of stream %d", stream);
+        if (pan && s3eSoundPoolStreamSetInt(stream, S3E_SOUNDPOOL_STREAM_PAN, pan))
+            s3eDebugTracePrintf("sound pool: cannot set the pan of stream %d", stream);
+
+        g_Voices[i] = stream;
+        return S3E_RESULT_SUCCESS;
+    }
+
+    // Retriggered one-shot pads layer their hits and give way to the
+    // looping pads when voices run out
+    SoundMixerPlayParams params;
+    SoundMixerPlayParamsInit(&params);
+    params.m_Repeat = repeat;
+    params.m_UserId = i;
+    params.m_Priority = i % 2 ? 0 : 1;
+    params.m_Pan = pan;
+    params.m_Rate = rate;
+
+    // Hits wait for the next step of the grid on the mixer's clock, so they
+    // keep time however the update loop is running
+    if (g_QuantizeFrames)
+        params.m_StartFrame = (SoundMixerGetClock() / g_QuantizeFrames + 1) * g_QuantizeFrames;
+
+    // Repeating pads swell in rather than starting abruptly
+    if (repeat != 1)
+        params.m_FadeIn = g_FadeFrames;
+
+    int voice = SoundMixerPlayEx(&g_SampleData[i], &params);
+    if (voice < 0)
+        return S3E_RESULT_ERROR;
+
+    g_Voices[i] = voice;
+    return S3E_RESULT_SUCCESS;
 }
 
 s3eResult Pause(int i)
 {
     if (g_UseSoundPool)
-        return s3eSoundPoolSamplePause(g_Samples[i]);
+        return s3eSoundPoolStreamPause(g_Voices[i]);
     else
-        return s3eSoundChannelPause(i);
+        return SoundMixerPause(g_Voices[i]);
 }
 
 s3eResult Resume(int i)
 {
     if (g_UseSoundPool)
-        return s3eSoundPoolSampleResume(g_Samples[i]);
+        return s3eSoundPoolStreamResume(g_Voices[i]);
     else
-        return s3eSoundChannelResume(i);
+        return SoundMixerResume(g_Voices[i]);
 }
 
 void ExampleInit()
 {
     g_UseSoundPool = s3eSoundPoolAvailable() == S3E_TRUE;
+
+    int mapSamples = 1;
+    s3eConfigGetInt("SoundBoard", "MapSamples", &mapSamples);
+    g_WavLoadMode = mapSamples ? WAV_LOAD_MAP : WAV_LOAD_COPY;
+    s3eConfigGetInt("SoundBoard", "StreamThreshold", &g_StreamThreshold);
+
+    char resample[S3E_CONFIG_STRING_MAX] = "play";
+    char resampleQuality[S3E_CONFIG_STRING_MAX] = "sinc";
+    s3eConfigGetString("SoundBoard", "Resample", resample);
+    s3eConfigGetString("SoundBoard", "ResampleQuality", resampleQuality);
+    g_ResampleOnLoad = !stricmp(resample, "load");
+    g_Resampling = !stricmp(resampleQuality, "linear") ? RESAMPLER_LINEAR : RESAMPLER_SINC;
+    s3eConfigGetInt("SoundBoard", "PitchVariation", &g_PitchVariation);
+    if (g_PitchVariation < 0 || g_PitchVariation > 50)
+        g_PitchVariation = 0;
+    s3eConfigGetInt("SoundBoard", "OutputBufferFrames", &g_OutputBufferFrames);
+    s3eConfigGetInt("SoundBoard", "OutputBuffers", &g_OutputBuffers);
+    s3eConfigGetInt("SoundBoard", "PanSpread", &g_PanSpread);
+    if (g_PanSpread < 0 || g_PanSpread > S3E_SOUNDPOOL_PAN_RIGHT)
+        g_PanSpread = 0;
+
+    int benchmark = 0;
+    s3eConfigGetInt("SoundBoard", "Benchmark", &benchmark);
+    if (benchmark)
+        SoundBenchRun();
     
-    // Read in sound data
-    // s3eSoundSetInt(S3E_SOUND_DEFAULT_FREQ, 8000);
-    DIR* d = opendir(".");
+    int loaderThreads = 4;
+    s3eConfigGetInt("SoundBoard", "LoaderThreads", &loaderThreads);
+
+    // A prebuilt bank replaces the data folder scan. An extension that can
+    // only load from a path is given the .wav files themselves instead.
+    char bankPath[S3E_CONFIG_STRING_MAX] = "sounds.bank";
+    s3eConfigGetString("SoundBoard", "Bank", bankPath);
+    if (bankPath[0] && (!g_UseSoundPool || s3eSoundPoolGetInt(S3E_SOUNDPOOL_LOAD_FROM_MEMORY) == 1))
+        g_Bank = SoundBankOpen(bankPath);
+
     int count = 0;
-    struct dirent* ent;
-    while ((ent = readdir(d)))
+    if (g_Bank)
     {
-        int len = strlen(ent->d_name);
-        if (len < 4 || stricmp(ent->d_name+len-4, ".wav"))
-            continue;
+        for (; count < SoundBankGetCount(g_Bank) && count < MAX_SAMPLES; count++)
+        {
+            g_Buttons[count] = g_Paths[count] = SoundBankGetName(g_Bank, count);
+            AddButton(g_Buttons[count], 20, 20 + 70 * count, 300, 50, (s3eKey)(s3eKey1 + count));
+        }
 
-        Load(count, ent->d_name);
-        s3eDebugTracePrintf("loaded sound %d (%d)", g_Samples[count], g_SampleDataLen[count]);
+        RegisterCallbacks();
 
-        ent->d_name[len-4] = '\0';
-        g_Buttons[count] = strdup(ent->d_name);
-        AddButton(g_Buttons[count], 20, 20 + 70 * count, 300, 50, (s3eKey)(s3eKey1 + count));
-        if (++count == MAX_SAMPLES)
-            break;
+        SampleLoaderStart(g_Paths, count, LoadFromBank, 0);
+        return;
+    }
+
+    s3eConfigGetInt("SoundBoard", "CacheBudget", &g_CacheBudget);
+    if (g_CacheBudget)
+        SampleCacheInit(MAX_SAMPLES, g_CacheBudget, CacheLoad, CacheUnload, CacheBusy);
+
+    // Find the sound data first; the pads are shown straight away and
+    // become playable as their samples finish loading. Unchanged files are
+    // listed from the manifest without reading the directory or opening them.
+    // s3eSoundSetInt(S3E_SOUND_DEFAULT_FREQ, 8000);
+    char manifestPath[S3E_CONFIG_STRING_MAX] = "soundboard.manifest";
+    s3eConfigGetString("SoundBoard", "Manifest", manifestPath);
+    count = AssetManifestScan(".", manifestPath, g_Assets, MAX_SAMPLES);
+
+    for (int i = 0; i < count; i++)
+    {
+        g_Paths[i] = g_Assets[i].m_Name;
+        char* pName = strdup(g_Assets[i].m_Name);
+        pName[strlen(pName)-4] = '\0';
+        g_Buttons[i] = pName;
+        AddButton(g_Buttons[i], 20, 20 + 70 * i, 300, 50, (s3eKey)(s3eKey1 + i));
     }
 
     RegisterCallbacks();
+
+    // The extension decodes in the background itself, so without a cache
+    // the pads need no loader threads. Each becomes playable when its
+    // load completes. Extensions that can only load synchronously are
+    // left to the SampleLoader, as are all pads if the load queue cannot be
+    // allocated.
+    if (g_UseSoundPool && !g_CacheBudget && s3eSoundPoolGetInt(S3E_SOUNDPOOL_ASYNC_LOAD) == 1 &&
+        SoundQueueInit(&g_LoadedSamples, sizeof(s3eSoundPoolLoadCompleteInfo), MAX_LOADED_SAMPLES))
+    {
+        g_AsyncLoad = s3eSoundPoolRegister(S3E_SOUNDPOOL_LOAD_COMPLETE, (s3eCallback)SampleLoaded, 0) == S3E_RESULT_SUCCESS;
+    }
+
+    if (g_AsyncLoad)
+    {
+        for (int i = 0; i < count; i++)
+        {
+            g_PoolLoadState[i] = SAMPLELOAD_PENDING;
+            g_Samples[i] = s3eSoundPoolSampleLoadAsync(g_Paths[i]);
+            if (g_Samples[i] == -1)
+                g_PoolLoadState[i] = SAMPLELOAD_FAILED;
+        }
+        return;
+    }
+
+    // The extension is not known to be safe to call from more than one
+    // thread, so samples it loads are loaded here, one at a time. With a
+    // cache the workers only size the samples and never call it.
+    if (g_UseSoundPool && !g_CacheBudget)
+        loaderThreads = 0;
+
+    SampleLoaderStart(g_Paths, count, Load, loaderThreads);
 }
 
 void ExampleShutDown()
 {
+    SampleLoaderWait();
+    SoundMixerTerminate();
+    SampleStreamTerminate();
+    if (g_CacheBudget)
+        SampleCacheTerminate();
+
     for (int i=0; i<MAX_SAMPLES; ++i)
+        SoundSampleRelease(&g_SampleData[i]);
+
+    // Samples adopted from the bank are released as they are unloaded,
+    // which must happen before the bank is closed
+    if (g_UseSoundPool && g_Bank)
     {
-        free(g_SampleData[i]);
-        g_SampleData[i] = NULL;
+        for (int i = 0; i < MAX_SAMPLES && g_Buttons[i]; i++)
+        {
+            if (SampleLoaderGetState(i) == SAMPLELOAD_READY)
+                s3eSoundPoolSampleUnload(g_Samples[i]);
+        }
     }
+    SoundBankClose(g_Bank);
+    g_Bank = NULL;
+    if (g_AsyncLoad)
+        s3eSoundPoolUnRegister(S3E_SOUNDPOOL_LOAD_COMPLETE, (s3eCallback)SampleLoaded);
+    SoundQueueDestroy(&g_LoadedSamples);
+    SoundQueueDestroy(&g_EndedSamples);
 }
 
 bool ExampleUpdate()
 {
+    SampleStreamUpdate();
+    SoundMixerUpdate();
+
+    // As for mixer voices, only the pad's latest hit drives its state
+    s3eSoundPoolEndSampleInfo ended;
+    while (SoundQueuePop(&g_EndedSamples, &ended))
+    {
+        s3eDebugTracePrintf("stream ended = %d (sample %d)", ended.m_StreamId, ended.m_SampleId);
+        for (int i = 0; i < MAX_SAMPLES && g_Buttons[i]; i++)
+        {
+            if (g_Samples[i] == ended.m_SampleId && g_Voices[i] == ended.m_StreamId)
+                g_SampleState[i] = 0;
+        }
+    }
+
+    // A dropped report would leave its pad playing for good, so after any
+    // are dropped each playing pad's stream is asked whether it still is
+    uint32 dropped = g_EndedDropped;
+    if (dropped != g_EndedDroppedSeen)
+    {
+        s3eDebugTracePrintf("sound pool: %u stream end reports dropped", dropped - g_EndedDroppedSeen);
+        g_EndedDroppedSeen = dropped;
+        for (int i = 0; i < MAX_SAMPLES && g_Buttons[i]; i++)
+        {
+            if (g_SampleState[i] == 1 && s3eSoundPoolStreamGetInt(g_Voices[i], S3E_SOUNDPOOL_STREAM_STATUS) != 1)
+                g_SampleState[i] = 0;
+        }
+    }
+
+    s3eSoundPoolLoadCompleteInfo loaded;
+    while (g_AsyncLoad && SoundQueuePop(&g_LoadedSamples, &loaded))
+    {
+        for (int i = 0; i < MAX_SAMPLES && g_Buttons[i]; i++)
+        {
+            if (g_Samples[i] == loaded.m_SampleId && g_PoolLoadState[i] == SAMPLELOAD_PENDING)
+                g_PoolLoadState[i] = loaded.m_Status == S3E_RESULT_SUCCESS ? SAMPLELOAD_READY : SAMPLELOAD_FAILED;
+        }
+    }
+
     for (int i = 0; i < MAX_SAMPLES; i++)
     {
         if (!g_Buttons[i])
             break;
+        if (LoadState(i) != SAMPLELOAD_READY)
+            continue;
         if (CheckButton(g_Buttons[i]) & S3E_KEY_STATE_RELEASED)
         {
             s3eDebugTracePrintf("pressed button %d", i);
@@ -244,9 +608,61 @@ bool ExampleUpdate()
 void ExampleRender()
 {
     int y = 150;
-    IwGxPrintString(30, y, g_UseSoundPool ? "Using Sound Pool" : "Using Sound Streaming");
+    if (g_UseSoundPool)
+    {
+        IwGxPrintString(30, y, "Using Sound Pool");
+    }
+    else
+    {
+        char buffer[0x100];
+        sprintf(buffer, "Using Software Mixer: %d voices, %u stolen", SoundMixerGetActiveVoices(), SoundMixerGetSteals());
+        IwGxPrintString(30, y, buffer);
+    }
     y += 20;
 
+    // What the device actually gave, so the smallest setting that doesn't
+    // underrun can be found for each device. Extensions that do not report
+    // output stats fail the reads, and nothing is shown.
+    {
+        int32 frames, buffers, latencyMs, underruns;
+        if (g_UseSoundPool)
+        {
+            frames = s3eSoundPoolGetInt(S3E_SOUNDPOOL_BUFFER_FRAMES);
+            buffers = s3eSoundPoolGetInt(S3E_SOUNDPOOL_BUFFER_COUNT);
+            latencyMs = s3eSoundPoolGetInt(S3E_SOUNDPOOL_LATENCY_MS);
+            underruns = s3eSoundPoolGetInt(S3E_SOUNDPOOL_UNDERRUNS);
+        }
+        else
+        {
+            SoundMixerOutputStats stats;
+            SoundMixerGetOutputStats(&stats);
+            frames = stats.m_BufferFrames;
+            buffers = stats.m_Buffers;
+            latencyMs = stats.m_LatencyMs;
+            underruns = stats.m_Underruns;
+        }
+
+        if (frames >= 0 && buffers >= 0 && latencyMs >= 0 && underruns >= 0)
+        {
+            char buffer[0x100];
+            sprintf(buffer, "Output: %d frames x %d, ~%d ms, %d underruns", frames, buffers, latencyMs, underruns);
+            IwGxPrintString(30, y, buffer);
+            y += 20;
+        }
+    }
+
+    if (g_CacheBudget)
+    {
+        SampleCacheStats stats;
+        SampleCacheGetStats(&stats);
+
+        char buffer[0x100];
+        sprintf(buffer, "Cache: %dK/%dK hit %u miss %u evict %u", stats.m_ResidentBytes >> 10,
+            stats.m_BudgetBytes >> 10, stats.m_Hits, stats.m_Misses, stats.m_Evictions);
+        IwGxPrintString(30, y, buffer);
+        y += 20;
+    }
+
     for (int i = 0; i < MAX_SAMPLES; i++)
     {
         if (!g_Buttons[i])
@@ -254,7 +670,12 @@ void ExampleRender()
 
         char buffer[0x100];
         const char* pState;
-        switch (g_SampleState[i])
+        SampleLoadState loadState = LoadState(i);
+        if (loadState == SAMPLELOAD_PENDING)
+            pState = "Loading";
+        else if (loadState == SAMPLELOAD_FAILED)
+            pState = "Failed";
+        else switch (g_SampleState[i])
         {
         case 1:
             pState = "Playing";